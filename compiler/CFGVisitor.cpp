@@ -1,21 +1,46 @@
 #include "CFGVisitor.h"
 #include "ir/Instruction.h"
+#include "CompileError.h"
+#include "ExpressionChain.h"
 #include <memory>
 #include <vector>
 
-CFGVisitor::CFGVisitor(): _cfg(), _returnBlock(nullptr), _mapFuncNameToSignature() {}
+CFGVisitor::CFGVisitor(IR::ControlFlowGraph& cfg, SymbolMapVisitor* symbols): _cfg(cfg), _symbols(symbols), _returnBlock(nullptr), _mapFuncNameToSignature() {}
 
 CFGVisitor::~CFGVisitor() {}
 
 antlrcpp::Any CFGVisitor::visitProg(ifccParser::ProgContext* ctx) {
+    if (_symbols) _symbols->reset();
     visitChildren(ctx);
+    if (_deferredError) std::rethrow_exception(_deferredError);
     return 0;
 }
 
+void CFGVisitor::deferError() {
+    if (!_symbols) throw;
+    if (!_deferredError) _deferredError = std::current_exception();
+}
+
+// with a separate pass, an undefined target is only reported after the checks of the whole program
+const IR::Variable& CFGVisitor::targetVar(Symbol name) {
+    try {
+        return _cfg.getSymbolVar(name);
+    }
+    catch (const CompileError&) {
+        deferError();
+        return _cfg.createTmpVar();
+    }
+}
+
 antlrcpp::Any CFGVisitor::visitFunction_def(ifccParser::Function_defContext* ctx) {
     std::string name(ctx->IDENTIFIER()[0]->getText());
     std::string signature(name);
 
+    if (_symbols) {
+        std::vector<Symbol> params;
+        for (size_t i = 1; i < ctx->IDENTIFIER().size(); ++i) params.push_back(intern(ctx->IDENTIFIER()[i]->getText()));
+        _symbols->beginFunction(name, params);
+    }
     _cfg.pushContext();
 
     IR::GenFunc* genFuncI;
@@ -35,11 +60,11 @@ antlrcpp::Any CFGVisitor::visitFunction_def(ifccParser::Function_defContext* ctx
         if (!types.empty() && !identifiers.empty()) {
             int i;
             for (i = 0; i < identifiers.size() && i < 6; ++i)
-                varList.push_back(_cfg.createSymbolVar(identifiers[i]->getText()));
+                varList.push_back(_cfg.createSymbolVar(intern(identifiers[i]->getText())));
             int addressPos = 8;
             for (; i <identifiers.size(); ++i) {
                 addressPos += 8;
-                varList.push_back(_cfg.createSymbolVar(identifiers[i]->getText(), addressPos));
+                varList.push_back(_cfg.createSymbolVar(intern(identifiers[i]->getText()), addressPos));
             }
         }
         signature += "(";
@@ -52,10 +77,13 @@ antlrcpp::Any CFGVisitor::visitFunction_def(ifccParser::Function_defContext* ctx
         _cfg.createAndAddBlock(signature);
         genFuncI = &_cfg.getCurrentBlock().addInstruction<IR::GenFunc>(name, varList);
     }
-    auto retBlock = _cfg.createBlock();
-    _returnBlock = retBlock.get();
+    if (_cfg.getOptions().profile) _cfg.getCurrentBlock().addInstruction<IR::ProfileEnter>(name);
+
+    IR::BasicBlock* retBlock = _cfg.createBlock();
+    _returnBlock = retBlock;
 
-    IR::Return retI = retBlock.get()->addInstruction<IR::Return>();
+    if (_cfg.getOptions().profile) retBlock->addInstruction<IR::ProfileExit>(name);
+    retBlock->addInstruction<IR::Return>();
     
     // Visiter le corps de la fonction
     for (auto stmt : ctx->stmt()) {
@@ -67,8 +95,9 @@ antlrcpp::Any CFGVisitor::visitFunction_def(ifccParser::Function_defContext* ctx
     // If we encountered any return we would jump to the return block directly and skip this instruction
     if (!name.compare("main")) _cfg.getCurrentBlock().addInstruction<IR::LdConst>(0);
 
-    _cfg.addBlock(std::move(retBlock));
+    _cfg.addBlock(retBlock);
     _cfg.popContext();
+    if (_symbols) _symbols->popContext();
     _returnBlock = nullptr;
     genFuncI->stackSize = _cfg.resetMemoryCount();
     return 0;
@@ -122,7 +151,8 @@ antlrcpp::Any CFGVisitor::visitStmt_while(ifccParser::Stmt_whileContext* ctx) {
 }
 
 antlrcpp::Any CFGVisitor::visitDeclaration(ifccParser::DeclarationContext* ctx) {
-    std::string varname = ctx->IDENTIFIER()->getText();
+    Symbol varname = intern(ctx->IDENTIFIER()->getText());
+    if (_symbols) _symbols->addVariable(varname);
     const auto& variable = _cfg.createSymbolVar(varname);
 
     if (ctx->expression()) {
@@ -133,8 +163,8 @@ antlrcpp::Any CFGVisitor::visitDeclaration(ifccParser::DeclarationContext* ctx)
 }
 
 antlrcpp::Any CFGVisitor::visitExpr_assign(ifccParser::Expr_assignContext* ctx) {
-    std::string varname = ctx->IDENTIFIER()->getText();
-    const auto& variable = _cfg.getSymbolVar(varname);
+    Symbol varname = intern(ctx->IDENTIFIER()->getText());
+    const auto& variable = targetVar(varname);
 
     visit(ctx->expression());
     _cfg.getCurrentBlock().addInstruction<IR::Store>(variable);
@@ -142,22 +172,10 @@ antlrcpp::Any CFGVisitor::visitExpr_assign(ifccParser::Expr_assignContext* ctx)
 }
 
 antlrcpp::Any CFGVisitor::visitExpr_arithmetic_add(ifccParser::Expr_arithmetic_addContext* ctx) {
-    const auto& lhs = visitAndStoreExpr(ctx->expression(0));
-    visit(ctx->expression(1));
-
-    if (ctx->OP_ADD()->getText() == "+") _cfg.getCurrentBlock().addInstruction<IR::Add>(lhs);
-    else _cfg.getCurrentBlock().addInstruction<IR::Sub>(lhs);
-    return 0;
+    return visitBinary(ctx);
 }
 antlrcpp::Any CFGVisitor::visitExpr_arithmetic_mult(ifccParser::Expr_arithmetic_multContext* ctx) {
-    const auto& lhs = visitAndStoreExpr(ctx->expression(0));
-    visit(ctx->expression(1));
-
-    auto op = ctx->OP_MULT()->getText();
-    if (op == "*") _cfg.getCurrentBlock().addInstruction<IR::Mul>(lhs);
-    else if (op == "/") _cfg.getCurrentBlock().addInstruction<IR::Div>(lhs);
-    else _cfg.getCurrentBlock().addInstruction<IR::Mod>(lhs);
-    return 0;
+    return visitBinary(ctx);
 }
 antlrcpp::Any CFGVisitor::visitExpr_arithmetic_unary(ifccParser::Expr_arithmetic_unaryContext* ctx) {
     visit(ctx->expression());
@@ -171,55 +189,29 @@ antlrcpp::Any CFGVisitor::visitExpr_arithmetic_unary(ifccParser::Expr_arithmetic
 }
 
 antlrcpp::Any CFGVisitor::visitExpr_arithmetic_bit_and(ifccParser::Expr_arithmetic_bit_andContext* ctx) {
-    const auto& lhs = visitAndStoreExpr(ctx->expression(0));
-    visit(ctx->expression(1));
-
-    _cfg.getCurrentBlock().addInstruction<IR::BitAnd>(lhs);
-    return 0;
+    return visitBinary(ctx);
 }
 
 antlrcpp::Any CFGVisitor::visitExpr_arithmetic_bit_xor(ifccParser::Expr_arithmetic_bit_xorContext* ctx) {
-    const auto& lhs = visitAndStoreExpr(ctx->expression(0));
-    visit(ctx->expression(1));
-
-    _cfg.getCurrentBlock().addInstruction<IR::BitXor>(lhs);
-    return 0;
+    return visitBinary(ctx);
 }
 
 antlrcpp::Any CFGVisitor::visitExpr_arithmetic_bit_or(ifccParser::Expr_arithmetic_bit_orContext* ctx) {
-    const auto& lhs = visitAndStoreExpr(ctx->expression(0));
-    visit(ctx->expression(1));
-
-    _cfg.getCurrentBlock().addInstruction<IR::BitOr>(lhs);
-    return 0;
+    return visitBinary(ctx);
 }
 
 antlrcpp::Any CFGVisitor::visitExpr_compare(ifccParser::Expr_compareContext* ctx) {
-    const auto& lhs = visitAndStoreExpr(ctx->expression(0));
-    visit(ctx->expression(1));
-
-    std::string op = ctx->OP_COMP()->getText();
-    if (op == ">") _cfg.getCurrentBlock().addInstruction<IR::CompGt>(lhs);
-    else if (op == "<") _cfg.getCurrentBlock().addInstruction<IR::CompLt>(lhs);
-    else if (op == ">=") _cfg.getCurrentBlock().addInstruction<IR::CompGtEq>(lhs);
-    else _cfg.getCurrentBlock().addInstruction<IR::CompLtEq>(lhs);
-    return 0;
+    return visitBinary(ctx);
 }
 
 antlrcpp::Any CFGVisitor::visitExpr_equal(ifccParser::Expr_equalContext* ctx) {
-    const auto& lhs = visitAndStoreExpr(ctx->expression(0));
-    visit(ctx->expression(1));
-
-    std::string op = ctx->OP_EQ()->getText();
-    if (op == "==") _cfg.getCurrentBlock().addInstruction<IR::CompEq>(lhs);
-    else _cfg.getCurrentBlock().addInstruction<IR::CompNe>(lhs);
-    return 0;
+    return visitBinary(ctx);
 }
 
 antlrcpp::Any CFGVisitor::visitExpr_arithmetic_aff_add(ifccParser::Expr_arithmetic_aff_addContext* ctx) {
     // a = a + ?
-    std::string varname = ctx->IDENTIFIER()->getText();
-    const auto& variable = _cfg.getSymbolVar(varname);
+    Symbol varname = intern(ctx->IDENTIFIER()->getText());
+    const auto& variable = targetVar(varname);
     // compute variable = a + ?
     visit(ctx->expression());
 
@@ -236,8 +228,8 @@ antlrcpp::Any CFGVisitor::visitExpr_arithmetic_aff_add(ifccParser::Expr_arithmet
 
 antlrcpp::Any CFGVisitor::visitExpr_post_incr(ifccParser::Expr_post_incrContext* ctx) {
     // b++ : we save the value of b in a tmp var that is put in eax at the end
-    std::string varname = ctx->IDENTIFIER()->getText();
-    const auto& variable = _cfg.getSymbolVar(varname);
+    Symbol varname = intern(ctx->IDENTIFIER()->getText());
+    const auto& variable = targetVar(varname);
     const auto& variableTmp = _cfg.createTmpVar();
     _cfg.getCurrentBlock().addInstruction<IR::LdLoc>(variable);
     _cfg.getCurrentBlock().addInstruction<IR::Store>(variableTmp);
@@ -257,8 +249,8 @@ antlrcpp::Any CFGVisitor::visitExpr_post_incr(ifccParser::Expr_post_incrContext*
 
 antlrcpp::Any CFGVisitor::visitExpr_pre_incr(ifccParser::Expr_pre_incrContext* ctx) {
     // ++b : we simply add 1 to b
-    std::string varname = ctx->IDENTIFIER()->getText();
-    const auto& variable = _cfg.getSymbolVar(varname);
+    Symbol varname = intern(ctx->IDENTIFIER()->getText());
+    const auto& variable = targetVar(varname);
 
     _cfg.getCurrentBlock().addInstruction<IR::LdConst>(1);
 
@@ -275,6 +267,7 @@ antlrcpp::Any CFGVisitor::visitExpr_pre_incr(ifccParser::Expr_pre_incrContext* c
 antlrcpp::Any CFGVisitor::visitExpr_fct_call(ifccParser::Expr_fct_callContext* ctx) {
     // Liste des identifiants (paramètres)
     auto expressions = ctx->expression();
+    if (_symbols) _symbols->checkCall(ctx->IDENTIFIER()->getText(), expressions.size());
     std::vector<std::string> registre = {"%edi", "%esi", "%edx", "%ecx", "%r8d", "%r9d"};
     std::vector<IR::Variable> varVector;
     varVector.clear();
@@ -298,73 +291,106 @@ antlrcpp::Any CFGVisitor::visitExpr_fct_call(ifccParser::Expr_fct_callContext* c
 }
 
 antlrcpp::Any CFGVisitor::visitExpr_arithmetic_lazy_and(ifccParser::Expr_arithmetic_lazy_andContext* ctx) {
-    visit(ctx->expression(0));  // On fait que visiter, on n'a pas besoin de stocker le résultat
-    _cfg.getCurrentBlock().addInstruction<IR::CastBool>();
-
-    // Createblock change le bloc actuel donc on a besoin de sauvegarder le bloc précédent
-    IR::BasicBlock& leftBlock = _cfg.getCurrentBlock();
-
-    // On change de bloc, on crée un nouveau bloc
-    // On veut aller dans ce bloc là si le précédent est vrai
-    IR::BasicBlock& rightBlock = _cfg.createAndAddBlock();
+    return visitBinary(ctx);
+}
 
-    // Si leftBlock donne vrai, on va sur le rightBlock
-    leftBlock.setExitTrue(rightBlock);
+antlrcpp::Any CFGVisitor::visitExpr_arithmetic_lazy_or(ifccParser::Expr_arithmetic_lazy_orContext* ctx) {
+    return visitBinary(ctx);
+}
 
-    // Expression vient du contexte, de la syntaxe antlr 
-    // Va le stocker par defaut dans reg
-    visit(ctx->expression(1));
-    _cfg.getCurrentBlock().addInstruction<IR::CastBool>();
+// The left operands of a chain of binary operators are visited in a loop (see ExpressionChain.h)
+antlrcpp::Any CFGVisitor::visitBinary(ifccParser::ExpressionContext* ctx) {
+    size_t base = _chain.size();
+    visit(leftChain(ctx, _chain));
+    while (_chain.size() > base) {
+        ifccParser::ExpressionContext* binary = _chain.back();
+        _chain.pop_back();
+        completeBinary(binary);
+    }
+    return 0;
+}
 
-    IR::BasicBlock& afterBlock = _cfg.createAndAddBlock();
-    leftBlock.setExitFalse(afterBlock);
+// The operator of a binary expression whose left operand has just been visited (its value is in the register)
+void CFGVisitor::completeBinary(ifccParser::ExpressionContext* ctx) {
+    if (dynamic_cast<ifccParser::Expr_arithmetic_lazy_andContext*>(ctx)) return completeLazy(rightOperand(ctx), true);
+    if (dynamic_cast<ifccParser::Expr_arithmetic_lazy_orContext*>(ctx)) return completeLazy(rightOperand(ctx), false);
 
-    // Peu importe comment est évalué la partie droite, son résultat détermine le résultat de left && right
-    rightBlock.setExit(afterBlock);
+    // the left operand is stored as in visitAndStoreExpr
+    const IR::Variable& lhs = _cfg.createTmpVar();
+    _cfg.getCurrentBlock().addInstruction<IR::Store>(lhs);
+    visit(rightOperand(ctx));
 
-    return 0;
+    IR::BasicBlock& current = _cfg.getCurrentBlock();
+    if (auto add = dynamic_cast<ifccParser::Expr_arithmetic_addContext*>(ctx)) {
+        if (add->OP_ADD()->getText() == "+") current.addInstruction<IR::Add>(lhs);
+        else current.addInstruction<IR::Sub>(lhs);
+    }
+    else if (auto mult = dynamic_cast<ifccParser::Expr_arithmetic_multContext*>(ctx)) {
+        auto op = mult->OP_MULT()->getText();
+        if (op == "*") current.addInstruction<IR::Mul>(lhs);
+        else if (op == "/") current.addInstruction<IR::Div>(lhs);
+        else current.addInstruction<IR::Mod>(lhs);
+    }
+    else if (dynamic_cast<ifccParser::Expr_arithmetic_bit_andContext*>(ctx)) current.addInstruction<IR::BitAnd>(lhs);
+    else if (dynamic_cast<ifccParser::Expr_arithmetic_bit_xorContext*>(ctx)) current.addInstruction<IR::BitXor>(lhs);
+    else if (dynamic_cast<ifccParser::Expr_arithmetic_bit_orContext*>(ctx)) current.addInstruction<IR::BitOr>(lhs);
+    else if (auto compare = dynamic_cast<ifccParser::Expr_compareContext*>(ctx)) {
+        std::string op = compare->OP_COMP()->getText();
+        if (op == ">") current.addInstruction<IR::CompGt>(lhs);
+        else if (op == "<") current.addInstruction<IR::CompLt>(lhs);
+        else if (op == ">=") current.addInstruction<IR::CompGtEq>(lhs);
+        else current.addInstruction<IR::CompLtEq>(lhs);
+    }
+    else {
+        std::string op = static_cast<ifccParser::Expr_equalContext*>(ctx)->OP_EQ()->getText();
+        if (op == "==") current.addInstruction<IR::CompEq>(lhs);
+        else current.addInstruction<IR::CompNe>(lhs);
+    }
 }
 
-antlrcpp::Any CFGVisitor::visitExpr_arithmetic_lazy_or(ifccParser::Expr_arithmetic_lazy_orContext* ctx) {
-    visit(ctx->expression(0));  // On fait que visiter, on n'a pas besoin de stocker le résultat
+// && (isAnd) and ||, the left operand has just been visited
+void CFGVisitor::completeLazy(ifccParser::ExpressionContext* right, bool isAnd) {
     _cfg.getCurrentBlock().addInstruction<IR::CastBool>();
 
     // Createblock change le bloc actuel donc on a besoin de sauvegarder le bloc précédent
     IR::BasicBlock& leftBlock = _cfg.getCurrentBlock();
 
     // On change de bloc, on crée un nouveau bloc
-    // On veut aller dans ce bloc là si le précédent est vrai
+    // On veut aller dans ce bloc là si le précédent est vrai (&&) ou faux (||)
     IR::BasicBlock& rightBlock = _cfg.createAndAddBlock();
+    if (isAnd) leftBlock.setExitTrue(rightBlock);
+    else leftBlock.setExitFalse(rightBlock);
 
-    // Si leftBlock donne faux, on va sur le rightBlock
-    leftBlock.setExitFalse(rightBlock);
-
-    // Expression vient du contexte, de la syntaxe antlr 
     // Va le stocker par defaut dans reg
-    visit(ctx->expression(1));
+    visit(right);
     _cfg.getCurrentBlock().addInstruction<IR::CastBool>();
 
     IR::BasicBlock& afterBlock = _cfg.createAndAddBlock();
-    leftBlock.setExitTrue(afterBlock);
+    if (isAnd) leftBlock.setExitFalse(afterBlock);
+    else leftBlock.setExitTrue(afterBlock);
 
-    // Peu importe comment est évalué la partie droite, son résultat détermine le résultat de left || right
+    // Peu importe comment est évalué la partie droite, son résultat détermine le résultat de left && right
     rightBlock.setExit(afterBlock);
-
-    return 0;
 }
 
 
 antlrcpp::Any CFGVisitor::visitExpr_ident(ifccParser::Expr_identContext* ctx) {
-    std::string varname = ctx->IDENTIFIER()->getText();
+    Symbol varname = intern(ctx->IDENTIFIER()->getText());
+    if (_symbols) _symbols->useVariable(varname);
     const auto& variable = _cfg.getSymbolVar(varname);
     _cfg.getCurrentBlock().addInstruction<IR::LdLoc>(variable);
     return 0;
 }
 
 antlrcpp::Any CFGVisitor::visitExpr_const(ifccParser::Expr_constContext* ctx) {
-    int value;
-    if (ctx->CONST_INT()) value = std::stoi(ctx->CONST_INT()->getText());
-    else value = (int)ctx->CONST_CHAR()->getText()[1];
+    int value = 0;
+    try {
+        if (ctx->CONST_INT()) value = intConstant(ctx->CONST_INT()->getText());
+        else value = (int)ctx->CONST_CHAR()->getText()[1];
+    }
+    catch (const CompileError&) {
+        deferError();
+    }
     _cfg.getCurrentBlock().addInstruction<IR::LdConst>(value);
     return 0;
 }
@@ -386,8 +412,10 @@ const IR::Variable& CFGVisitor::visitAndStoreExpr(ifccParser::ExpressionContext*
 
 antlrcpp::Any CFGVisitor::visitStmt_block(ifccParser::Stmt_blockContext* ctx)
 {
+    if (_symbols) _symbols->pushContext();
     _cfg.pushContext();
     ifccBaseVisitor::visitStmt_block(ctx);
     _cfg.popContext();
+    if (_symbols) _symbols->popContext();
     return 0;
 }
\ No newline at end of file
@@ -3,9 +3,17 @@
 #include "antlr4-runtime.h"
 #include "generated/ifccBaseVisitor.h"
 #include "ir/ControlFlowGraph.h"
+#include "SymbolMapVisitor.h"
+
+/*
+    Generates the IR of the ANTLR tree.
+    With --sema=fused, the checks of SymbolMapVisitor are made by the same walk: its methods are called at the
+    points where SymbolMapVisitor calls them, so its diagnostics are the same as with a separate pass, and the
+    errors of the IR generation itself are only raised once the whole program has been checked.
+*/
 class  CFGVisitor : public ifccBaseVisitor {
 public:
-    CFGVisitor();
+    CFGVisitor(IR::ControlFlowGraph& cfg, SymbolMapVisitor* symbols = nullptr);
     ~CFGVisitor();
 
     virtual antlrcpp::Any visitProg(ifccParser::ProgContext* ctx) override;
@@ -43,7 +51,16 @@ public:
 
     inline IR::ControlFlowGraph& getCFG() { return _cfg; }
 private:
-    IR::ControlFlowGraph _cfg;
+    const IR::Variable& targetVar(Symbol name); // variable assigned or incremented, not checked by SymbolMapVisitor
+    void deferError(); // with --sema=fused, keeps the current exception until the end of the program
+    antlrcpp::Any visitBinary(ifccParser::ExpressionContext* ctx); // the binary operators, see ExpressionChain.h
+    void completeBinary(ifccParser::ExpressionContext* ctx);
+    void completeLazy(ifccParser::ExpressionContext* right, bool isAnd);
+
+    IR::ControlFlowGraph& _cfg;
+    SymbolMapVisitor* _symbols; // the checks made during the walk with --sema=fused, nullptr otherwise
+    std::exception_ptr _deferredError;
     IR::BasicBlock* _returnBlock;
     std::map<std::string, std::string> _mapFuncNameToSignature;
+    std::vector<ifccParser::ExpressionContext*> _chain; // work stack of visitBinary
 };
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+/*
+    Error which stops the compilation of a translation unit.
+    The driver prints "error: " followed by the message in the diagnostics of the unit, whose exit status is 1.
+*/
+class CompileError : public std::runtime_error {
+public:
+    CompileError(const std::string& message) : std::runtime_error(message) {}
+};
+
+// Value of an integer constant of the source, which must fit in an int
+inline int intConstant(const std::string& text)
+{
+    try {
+        return std::stoi(text);
+    }
+    catch (const std::out_of_range&) {
+        throw CompileError("Constant " + text + " too large.");
+    }
+}
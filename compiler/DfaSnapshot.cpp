@@ -0,0 +1,339 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <unistd.h>
+
+#include "antlr4-runtime.h"
+#include "generated/ifccParser.h"
+#include "DfaSnapshot.h"
+
+using namespace antlr4;
+
+/*
+    File format, 64-bit integers in the byte order of the machine:
+        "ifccdfa1", fingerprint of the ATN
+        contexts: count, then for each one its kind (EMPTY_CONTEXT, SINGLETON_CONTEXT or ARRAY_CONTEXT), its size
+            and its (parent, return state) pairs, a parent being the index of a previous context or NONE
+        decisions: count, then for each one
+            its number and its number of states
+            the states: their configurations (ATN state, alt, context, reachesIntoOuterContext), uniqueAlt, the
+            conflicting alts, isAcceptState, requiresFullContext and prediction
+            the edges of each state: (symbol, target) pairs, the target being a state of the decision or ERROR_STATE
+            the start states: (precedence, state) pairs for a precedence DFA, the index of s0 or NONE otherwise
+*/
+static const char MAGIC[8] = { 'i', 'f', 'c', 'c', 'd', 'f', 'a', '1' };
+static const uint64_t NONE = UINT64_MAX;
+static const uint64_t ERROR_STATE = UINT64_MAX - 1; // edge to ATNSimulator::ERROR, the prediction fails
+enum ContextKind : uint64_t { EMPTY_CONTEXT, SINGLETON_CONTEXT, ARRAY_CONTEXT };
+
+// The states of the ATN and their transitions, the DFA of another grammar must not be loaded
+static uint64_t fingerprint(const atn::ATN& atn)
+{
+    uint64_t hash = 14695981039346656037ull; // FNV-1a
+    auto mix = [&](uint64_t value) { hash = (hash ^ value) * 1099511628211ull; };
+    mix(atn.states.size());
+    mix(atn.decisionToState.size());
+    for (atn::ATNState* state : atn.states) {
+        if (!state) {
+            mix(NONE); // removed by the deserializer
+            continue;
+        }
+        mix(state->getStateType());
+        mix(state->ruleIndex);
+        mix(state->getNumberOfTransitions());
+        for (size_t i = 0; i < state->getNumberOfTransitions(); ++i) {
+            mix((uint64_t)state->transition(i)->getSerializationType());
+            mix(state->transition(i)->target->stateNumber);
+        }
+    }
+    return hash;
+}
+
+static void put(std::string& out, uint64_t value)
+{
+    out.append((const char*)&value, sizeof(value));
+}
+
+// the states without predicates only: the semantic contexts are not saved
+static bool isSaved(const dfa::DFA& decision)
+{
+    for (dfa::DFAState* state : decision.states) {
+        if (!state->predicates.empty()) return false;
+        for (const auto& config : state->configs->configs)
+            if (config->semanticContext != atn::SemanticContext::NONE) return false;
+    }
+    return !decision.states.empty();
+}
+
+// Numbers the contexts reachable from `context`, the parents before their children
+static void numberContexts(const Ref<atn::PredictionContext>& context, std::unordered_map<const atn::PredictionContext*, uint64_t>& ids,
+    std::vector<Ref<atn::PredictionContext>>& contexts)
+{
+    if (!context || ids.count(context.get())) return;
+    if (!context->isEmpty())
+        for (size_t i = 0; i < context->size(); ++i) numberContexts(context->getParent(i), ids, contexts);
+    ids[context.get()] = contexts.size();
+    contexts.push_back(context);
+}
+
+bool saveDfaSnapshot(const std::filesystem::path& path, std::ostream& diagnostics)
+{
+    ifccParser parser(nullptr); // the DFA are static, shared by all the parsers
+    std::vector<dfa::DFA>& decisions = parser.getInterpreter<atn::ParserATNSimulator>()->decisionToDFA;
+
+    std::unordered_map<const atn::PredictionContext*, uint64_t> contextIds;
+    std::vector<Ref<atn::PredictionContext>> contexts;
+    std::vector<dfa::DFA*> saved;
+    for (dfa::DFA& decision : decisions) {
+        if (!isSaved(decision)) continue;
+        saved.push_back(&decision);
+        for (dfa::DFAState* state : decision.states)
+            for (const auto& config : state->configs->configs) numberContexts(config->context, contextIds, contexts);
+    }
+
+    std::string out(MAGIC, sizeof(MAGIC));
+    put(out, fingerprint(parser.getATN()));
+    put(out, contexts.size());
+    for (const auto& context : contexts) {
+        bool array = dynamic_cast<const atn::ArrayPredictionContext*>(context.get()) != nullptr;
+        put(out, context->isEmpty() ? EMPTY_CONTEXT : array ? ARRAY_CONTEXT : SINGLETON_CONTEXT);
+        put(out, context->isEmpty() ? 0 : context->size());
+        if (context->isEmpty()) continue;
+        for (size_t i = 0; i < context->size(); ++i) {
+            Ref<atn::PredictionContext> parent = context->getParent(i);
+            put(out, parent ? contextIds[parent.get()] : NONE);
+            put(out, context->getReturnState(i));
+        }
+    }
+
+    put(out, saved.size());
+    for (dfa::DFA* decision : saved) {
+        // in the order of their creation, so that a snapshot of the same DFA is the same file
+        std::vector<dfa::DFAState*> states(decision->states.begin(), decision->states.end());
+        std::sort(states.begin(), states.end(), [](dfa::DFAState* a, dfa::DFAState* b) { return a->stateNumber < b->stateNumber; });
+        std::unordered_map<const dfa::DFAState*, uint64_t> stateIds;
+        for (size_t i = 0; i < states.size(); ++i) stateIds[states[i]] = i;
+        stateIds[atn::ATNSimulator::ERROR.get()] = ERROR_STATE;
+
+        put(out, decision->decision);
+        put(out, states.size());
+        for (dfa::DFAState* state : states) {
+            put(out, state->configs->configs.size());
+            for (const auto& config : state->configs->configs) {
+                put(out, config->state->stateNumber);
+                put(out, config->alt);
+                put(out, config->context ? contextIds[config->context.get()] : NONE);
+                put(out, config->reachesIntoOuterContext); // and the flag of the precedence filter
+            }
+            put(out, (uint64_t)state->configs->uniqueAlt);
+            std::vector<uint64_t> conflictingAlts;
+            for (size_t alt = 0; alt < state->configs->conflictingAlts.size(); ++alt)
+                if (state->configs->conflictingAlts.test(alt)) conflictingAlts.push_back(alt);
+            put(out, conflictingAlts.size());
+            for (uint64_t alt : conflictingAlts) put(out, alt);
+            put(out, state->isAcceptState);
+            put(out, state->requiresFullContext);
+            put(out, state->prediction);
+        }
+
+        auto putEdges = [&](const dfa::DFAState* state) {
+            std::vector<std::pair<uint64_t, uint64_t>> edges;
+            for (const auto& edge : state->edges) {
+                auto target = stateIds.find(edge.second);
+                if (target != stateIds.end()) edges.emplace_back(edge.first, target->second);
+            }
+            std::sort(edges.begin(), edges.end());
+            put(out, edges.size());
+            for (const auto& edge : edges) {
+                put(out, edge.first);
+                put(out, edge.second);
+            }
+        };
+        for (dfa::DFAState* state : states) putEdges(state);
+        // the start states of a precedence DFA are the edges of its s0, by precedence
+        if (decision->isPrecedenceDfa()) putEdges(decision->s0);
+        else put(out, decision->s0 && stateIds.count(decision->s0) ? stateIds[decision->s0] : NONE);
+    }
+
+    // written next to the snapshot then renamed, a compiler starting meanwhile never reads a partial file
+    std::filesystem::path temporary = path.string() + ".tmp" + std::to_string(getpid());
+    std::ofstream file(temporary, std::ios::binary);
+    file.write(out.data(), out.size());
+    file.close();
+    std::error_code error;
+    if (!file.fail()) std::filesystem::rename(temporary, path, error);
+    if (file.fail() || error) {
+        std::filesystem::remove(temporary, error);
+        diagnostics << "error: cannot write the DFA snapshot " << path.string() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+namespace {
+
+// Reads the integers of the snapshot, invalid once the end of the file is passed
+struct SnapshotReader {
+    const std::string& content;
+    size_t position = 0;
+    bool valid = true;
+
+    uint64_t next()
+    {
+        uint64_t value = 0;
+        if (content.size() - position < sizeof(value)) valid = false;
+        else memcpy(&value, content.data() + position, sizeof(value));
+        position += valid ? sizeof(value) : 0;
+        return value;
+    }
+
+    // a number of elements, which cannot be larger than the rest of the file
+    uint64_t count()
+    {
+        uint64_t value = next();
+        if (value > (content.size() - position) / sizeof(value)) valid = false;
+        return valid ? value : 0;
+    }
+};
+
+struct LoadedDecision {
+    size_t decision;
+    std::vector<std::unique_ptr<dfa::DFAState>> states; // owned by the DFA once installed
+    std::vector<std::pair<int, dfa::DFAState*>> precedenceStarts;
+    dfa::DFAState* s0 = nullptr;
+};
+
+}
+
+// The states of a decision. Returns false if the snapshot is invalid
+static bool readDecision(SnapshotReader& in, const atn::ATN& atn, const std::vector<Ref<atn::PredictionContext>>& contexts,
+    bool precedence, LoadedDecision& loaded)
+{
+    uint64_t stateCount = in.count();
+    for (uint64_t i = 0; i < stateCount && in.valid; ++i) {
+        auto configs = std::make_unique<atn::ATNConfigSet>(false); // the configurations of SLL prediction
+        uint64_t configCount = in.count();
+        for (uint64_t j = 0; j < configCount && in.valid; ++j) {
+            uint64_t stateNumber = in.next(), alt = in.next(), context = in.next(), reachesIntoOuterContext = in.next();
+            if (stateNumber >= atn.states.size() || !atn.states[stateNumber] || (context != NONE && context >= contexts.size())) return false;
+            auto config = std::make_shared<atn::ATNConfig>(atn.states[stateNumber], alt, context == NONE ? nullptr : contexts[context]);
+            config->reachesIntoOuterContext = reachesIntoOuterContext;
+            configs->add(config);
+        }
+        configs->uniqueAlt = (decltype(configs->uniqueAlt))in.next();
+        uint64_t conflictCount = in.count();
+        for (uint64_t j = 0; j < conflictCount && in.valid; ++j) {
+            uint64_t alt = in.next();
+            if (alt >= configs->conflictingAlts.size()) return false;
+            configs->conflictingAlts.set(alt);
+        }
+        configs->setReadonly(true);
+
+        auto state = std::make_unique<dfa::DFAState>(std::move(configs));
+        state->isAcceptState = in.next() != 0;
+        state->requiresFullContext = in.next() != 0;
+        state->prediction = in.next();
+        loaded.states.push_back(std::move(state));
+    }
+
+    auto target = [&](uint64_t id) -> dfa::DFAState* {
+        if (id == ERROR_STATE) return atn::ATNSimulator::ERROR.get();
+        return id < loaded.states.size() ? loaded.states[id].get() : nullptr;
+    };
+    auto readEdges = [&](const std::function<void(uint64_t, dfa::DFAState*)>& add) {
+        uint64_t edgeCount = in.count();
+        for (uint64_t j = 0; j < edgeCount && in.valid; ++j) {
+            uint64_t symbol = in.next();
+            dfa::DFAState* to = target(in.next());
+            if (to) add(symbol, to);
+            else in.valid = false;
+        }
+    };
+    for (auto& state : loaded.states) readEdges([&](uint64_t symbol, dfa::DFAState* to) { state->edges[symbol] = to; });
+    if (precedence) readEdges([&](uint64_t precedence, dfa::DFAState* to) { loaded.precedenceStarts.emplace_back((int)precedence, to); });
+    else {
+        uint64_t s0 = in.next();
+        if (s0 != NONE && !(loaded.s0 = target(s0))) return false;
+    }
+    return in.valid;
+}
+
+bool loadDfaSnapshot(const std::filesystem::path& path, std::ostream& diagnostics)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        diagnostics << "warning: cannot read the DFA snapshot " << path.string() << std::endl;
+        return false;
+    }
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    ifccParser parser(nullptr); // the DFA are static, shared by all the parsers
+    std::vector<dfa::DFA>& decisions = parser.getInterpreter<atn::ParserATNSimulator>()->decisionToDFA;
+    const atn::ATN& atn = parser.getATN();
+    SnapshotReader in{ content };
+    if (content.compare(0, sizeof(MAGIC), MAGIC, sizeof(MAGIC)) != 0) {
+        diagnostics << "warning: " << path.string() << " is not a DFA snapshot of ifcc" << std::endl;
+        return false;
+    }
+    in.position = sizeof(MAGIC);
+    if (in.next() != fingerprint(atn)) {
+        diagnostics << "warning: the DFA snapshot " << path.string() << " was saved with another grammar and is ignored" << std::endl;
+        return false;
+    }
+
+    std::vector<Ref<atn::PredictionContext>> contexts;
+    uint64_t contextCount = in.count();
+    for (uint64_t i = 0; i < contextCount && in.valid; ++i) {
+        uint64_t kind = in.next(), size = in.count();
+        std::vector<Ref<atn::PredictionContext>> parents;
+        std::vector<size_t> returnStates;
+        for (uint64_t j = 0; j < size && in.valid; ++j) {
+            uint64_t parent = in.next();
+            if (parent != NONE && parent >= contexts.size()) in.valid = false;
+            parents.push_back(parent == NONE || !in.valid ? nullptr : contexts[parent]);
+            returnStates.push_back(in.next());
+        }
+        if (kind == EMPTY_CONTEXT) contexts.push_back(atn::PredictionContext::EMPTY);
+        else if (kind == SINGLETON_CONTEXT && size == 1 && parents[0]) contexts.push_back(atn::SingletonPredictionContext::create(parents[0], returnStates[0]));
+        else if (kind == ARRAY_CONTEXT && size > 0) contexts.push_back(std::make_shared<atn::ArrayPredictionContext>(parents, returnStates));
+        else in.valid = false;
+    }
+
+    std::vector<LoadedDecision> loaded;
+    uint64_t decisionCount = in.count();
+    for (uint64_t i = 0; i < decisionCount && in.valid; ++i) {
+        loaded.emplace_back();
+        loaded.back().decision = in.next();
+        if (loaded.back().decision >= decisions.size() || !decisions[loaded.back().decision].states.empty()) in.valid = false;
+        else in.valid = readDecision(in, atn, contexts, decisions[loaded.back().decision].isPrecedenceDfa(), loaded.back());
+    }
+    if (!in.valid || in.position != content.size()) {
+        diagnostics << "warning: the DFA snapshot " << path.string() << " is invalid and is ignored" << std::endl;
+        return false;
+    }
+
+    // the DFA are only modified once the whole snapshot is read, numbered as addDFAState does
+    for (LoadedDecision& snapshot : loaded) {
+        dfa::DFA& target = decisions[snapshot.decision];
+        decltype(target.states) states;
+        for (auto& state : snapshot.states) {
+            state->stateNumber = (int)states.size();
+            states.insert(state.get());
+        }
+        if (states.size() != snapshot.states.size()) continue; // two equal states, the snapshot is not the one of a DFA
+        target.states = std::move(states);
+        for (auto& state : snapshot.states) state.release();
+        if (target.isPrecedenceDfa()) {
+            for (const auto& start : snapshot.precedenceStarts) target.setPrecedenceStartState(start.first, start.second);
+        }
+        else target.s0 = snapshot.s0;
+    }
+    return true;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <filesystem>
+#include <iostream>
+
+/*
+    Snapshot of the DFA cache of the ANTLR parser (--dfa=FILE, --dfa-save=FILE).
+
+    The parser keeps the states of its adaptive prediction in static DFA, which start empty in each ifcc process:
+    the first parse of a short-lived compiler pays the full cost of the ATN simulation for every decision it meets.
+    A training run over a corpus (make dfa, on tests/testfiles) saves the warmed DFA of every decision, and the
+    compiler loads them at startup before the first parse with --dfa=FILE (make dfa writes ifcc.dfa).
+
+    The snapshot holds the DFA states with their ATN configurations, whose graph-structured prediction contexts are
+    written once each, and their edges, including the start states of the precedence DFA of the left recursive rule
+    `expression`. It is only loaded if the ATN it was saved with has the same fingerprint, so a snapshot of an older
+    grammar is ignored. The decisions whose states have predicates (none in ifcc.g4) are not saved.
+
+    The DFA of the lexer is not saved: its configurations keep whether they went through a non-greedy loop
+    (the comments and directives), which cannot be restored through the runtime API, and it is warm after the
+    first few tokens anyway.
+*/
+
+// Loads the snapshot into the DFA of the parser, which must not have been used yet. Returns false and writes
+// the reason on `diagnostics` if the file cannot be read or was saved by another grammar, the DFA stay empty
+bool loadDfaSnapshot(const std::filesystem::path& path, std::ostream& diagnostics);
+
+// Writes the DFA of the parser, after the compilations of a training run. Returns false if the file cannot be written
+bool saveDfaSnapshot(const std::filesystem::path& path, std::ostream& diagnostics);
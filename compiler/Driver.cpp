@@ -0,0 +1,681 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <pthread.h>
+
+#include "antlr4-runtime.h"
+#include "generated/ifccLexer.h"
+#include "generated/ifccParser.h"
+#include "generated/ifccBaseVisitor.h"
+
+#include "Driver.h"
+#include "CompileError.h"
+#include "CFGVisitor.h"
+#include "SymbolMapVisitor.h"
+#include "elf/ObjectWriter.h"
+#include "x86/Jit.h"
+#include "ir/Interpreter.h"
+#include "ast/Lexer.h"
+#include "ast/Parser.h"
+#include "ast/SymbolCheck.h"
+#include "ast/CFGBuilder.h"
+#include "ast/TokenWindow.h"
+#include "TimeReport.h"
+#include "WorkStealingPool.h"
+#include "FunctionCache.h"
+#include "ir/Runtime.h"
+#include "ir/AsmBuffer.h"
+#include "SourceFile.h"
+#include "Symbol.h"
+
+// Same messages as the ConsoleErrorListener of ANTLR, on the diagnostics of the translation unit
+class DiagnosticsErrorListener : public antlr4::BaseErrorListener {
+public:
+    DiagnosticsErrorListener(std::ostream& diagnostics) : _diagnostics(diagnostics) {}
+
+    void syntaxError(antlr4::Recognizer* recognizer, antlr4::Token* offendingSymbol, size_t line, size_t charPositionInLine,
+        const std::string& msg, std::exception_ptr e) override
+    {
+        _diagnostics << "line " << line << ":" << charPositionInLine << " " << msg << std::endl;
+    }
+
+private:
+    std::ostream& _diagnostics;
+};
+
+/*
+    Two-stage parsing: SLL prediction is much cheaper than full LL and gives the same tree for all the valid
+    inputs it accepts. The first stage stops at the first error without reporting it, the input is then
+    reparsed with full LL and the default error strategy, so the syntax errors are the ones of a full LL parse.
+*/
+static antlr4::tree::ParseTree* parseTwoStage(ifccParser& parser, antlr4::CommonTokenStream& tokens, bool fullLLOnly,
+    antlr4::ANTLRErrorListener& errorListener)
+{
+    auto interpreter = parser.getInterpreter<antlr4::atn::ParserATNSimulator>();
+    parser.removeErrorListeners();
+    if (!fullLLOnly) {
+        interpreter->setPredictionMode(antlr4::atn::PredictionMode::SLL);
+        parser.setErrorHandler(std::make_shared<antlr4::BailErrorStrategy>());
+        try {
+            return parser.axiom();
+        }
+        catch (const antlr4::ParseCancellationException&) {
+            tokens.seek(0);
+            parser.reset();
+            parser.setErrorHandler(std::make_shared<antlr4::DefaultErrorStrategy>());
+        }
+    }
+    parser.addErrorListener(&errorListener);
+    interpreter->setPredictionMode(antlr4::atn::PredictionMode::LL);
+    return parser.axiom();
+}
+
+// Tokens of the definition of a function, separated by '\0', and the names of the functions it calls
+struct FunctionTokens {
+    std::string name;
+    std::string text;
+    std::set<std::string> callees;
+};
+
+static FunctionTokens functionTokens(antlr4::TokenStream& tokens, size_t first, size_t last)
+{
+    FunctionTokens function;
+    antlr4::Token* previous = nullptr;
+    for (size_t i = first; i <= last; ++i) {
+        antlr4::Token* token = tokens.get(i);
+        if (token->getChannel() != antlr4::Token::DEFAULT_CHANNEL) continue;
+        std::string text = token->getText();
+        if (previous && previous->getType() == ifccLexer::IDENTIFIER && text == "(") {
+            if (function.name.empty()) function.name = previous->getText();
+            else function.callees.insert(previous->getText());
+        }
+        function.text += text;
+        function.text += '\0';
+        previous = token;
+    }
+    return function;
+}
+
+/*
+    Keys of the functions in the cache: the tokens of the function, the options changing its code and the compiler.
+    With -O, the calls of pure functions are evaluated at compile time, so the key also contains the functions it
+    can call (directly or not), which are added to `callees`: their IR must be built to compile the function.
+*/
+static std::vector<std::string> cacheKeys(const Options& options, antlr4::TokenStream& tokens,
+    const std::vector<std::pair<size_t, size_t>>& ranges, std::vector<std::vector<size_t>>& callees)
+{
+    std::vector<FunctionTokens> functions;
+    std::map<std::string, size_t> indices;
+    for (const auto& range : ranges) {
+        functions.push_back(functionTokens(tokens, range.first, range.second));
+        indices[functions.back().name] = functions.size() - 1;
+    }
+
+    std::ostringstream common;
+    common << "ifcc function cache 1\n" << FunctionCache::compilerIdentity() << "\n"
+        << options.optimize << options.profile << options.bufferedIO << options.freestanding << "\n";
+    std::vector<std::string> keys;
+    callees.assign(functions.size(), {});
+    for (size_t i = 0; i < functions.size(); ++i) {
+        std::string content = common.str() + functions[i].text;
+        if (options.optimize) {
+            std::set<std::string> reached;
+            std::vector<std::string> pending(functions[i].callees.begin(), functions[i].callees.end());
+            while (!pending.empty()) {
+                std::string name = pending.back();
+                pending.pop_back();
+                if (!indices.count(name) || !reached.insert(name).second) continue;
+                const auto& callee = functions[indices[name]];
+                pending.insert(pending.end(), callee.callees.begin(), callee.callees.end());
+            }
+            for (const auto& name : reached) {
+                content += "\n" + functions[indices[name]].text;
+                if (indices[name] != i) callees[i].push_back(indices[name]);
+            }
+        }
+        keys.push_back(FunctionCache::key(content));
+    }
+    return keys;
+}
+
+// the assembly of the translation unit is written with a single system call
+static int writeAssembly(const IR::AsmBuffer& assembly, const Options& options, TimeReport& timeReport, std::ostream& diagnostics)
+{
+    timeReport.phase("writing");
+    if (!assembly.writeFile(options.outputPath)) {
+        diagnostics << "error: cannot write file: " << options.outputPath.string() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+/*
+    -j N with a single input, or --cache: the IR generation, the optimizations and the code generation of each
+    function are tasks of a work-stealing pool. Each function has its own ControlFlowGraph and output buffer, and
+    the output is the one of a single graph, byte for byte:
+    - the labels of the graph of a function are numbered after the ones of the functions before it
+    - the pure calls of all the functions are evaluated before any of them is folded, as in ControlFlowGraph::optimize,
+      by a single evaluator in the order of the source: the step budget of the unit is spent as with one graph
+    - the outputs of the functions are written in the order of the source
+    With the cache, the functions found in it are not compiled, and the other ones are stored with their labels
+    numbered from 0 before being relabeled like the cached ones. When the step budget of the evaluation is used up,
+    what is folded in a function depends on the functions before it, which are not in its key: nothing is stored.
+    The machine code of -c is encoded by a single thread, the encoder resolves the labels of the whole unit.
+    The tasks intern the names in the table of the unit (Symbol.h), whichever thread of the pool runs them.
+*/
+static int compileFunctions(const Options& options, antlr4::TokenStream* tokens, const std::vector<std::pair<size_t, size_t>>& ranges,
+    const std::function<void(IR::ControlFlowGraph&, size_t)>& buildFunction, const std::set<std::string>& pureFunctions,
+    TimeReport& timeReport, std::ostream& diagnostics)
+{
+    size_t functionCount = ranges.size();
+    // no more threads than tasks, the functions are the largest number of tasks of a run
+    WorkStealingPool pool((unsigned)std::min<size_t>(options.jobs, functionCount));
+    Interner& interner = currentInterner();
+    auto runTasks = [&](size_t count, const std::function<void(size_t, unsigned)>& task) {
+        pool.run(count, [&](size_t i, unsigned thread) {
+            InternerScope scope(interner);
+            task(i, thread);
+        });
+    };
+    std::vector<std::unique_ptr<IR::ControlFlowGraph>> cfgs(functionCount);
+
+    std::unique_ptr<FunctionCache> cache;
+    std::vector<std::string> keys;
+    std::vector<std::vector<size_t>> callees;
+    std::vector<FunctionCache::Entry> entries(functionCount);
+    std::vector<char> cached(functionCount, false);
+    if (!options.cacheDirectory.empty()) {
+        timeReport.phase("cache lookup");
+        cache = std::make_unique<FunctionCache>(options.cacheDirectory, options.cacheSize);
+        keys = cacheKeys(options, *tokens, ranges, callees);
+        runTasks(functionCount, [&](size_t i, unsigned) { cached[i] = cache->load(keys[i], entries[i]); });
+    }
+
+    // the functions to compile, and with the cache and -O, the ones they call
+    std::vector<size_t> built;
+    std::vector<char> needed(functionCount, false);
+    for (size_t i = 0; i < functionCount; ++i) {
+        if (cached[i]) continue;
+        needed[i] = true;
+        if (cache) for (size_t callee : callees[i]) needed[callee] = true;
+    }
+    for (size_t i = 0; i < functionCount; ++i) if (needed[i]) built.push_back(i);
+
+    timeReport.phase("IR generation");
+    runTasks(built.size(), [&](size_t k, unsigned) {
+        cfgs[built[k]] = std::make_unique<IR::ControlFlowGraph>(options);
+        buildFunction(*cfgs[built[k]], built[k]);
+    });
+
+    bool storable = true;
+    if (options.optimize) {
+        timeReport.phase("optimization");
+        std::vector<const IR::ControlFlowGraph*> program;
+        for (size_t i : built) program.push_back(cfgs[i].get());
+        auto evaluator = IR::ControlFlowGraph::createEvaluator(program);
+        std::vector<std::vector<std::vector<IR::FoldedInstruction>>> folded(functionCount);
+        for (size_t i = 0; i < functionCount; ++i) {
+            if (!cached[i]) folded[i] = cfgs[i]->evaluatePureCalls(pureFunctions, *evaluator);
+        }
+        storable = !evaluator->isTotalStepLimitReached();
+        runTasks(functionCount, [&](size_t i, unsigned) { if (!cached[i]) cfgs[i]->optimize(folded[i]); });
+    }
+    if (options.memReport) {
+        IR::ArenaStatistics statistics;
+        for (size_t i : built) statistics += cfgs[i]->getArenaStatistics();
+        statistics.print(diagnostics);
+    }
+
+    timeReport.phase("code generation");
+    std::vector<IR::AsmBuffer> outputs(functionCount);
+    if (cache) {
+        runTasks(functionCount, [&](size_t i, unsigned) {
+            if (cached[i]) return;
+            IR::AsmBuffer output;
+            cfgs[i]->generateFunctionsAsm(output);
+            entries[i] = { cfgs[i]->getBlockCount(), cfgs[i]->getStringCount(), std::string(output.view()) };
+            if (storable) cache->store(keys[i], entries[i]);
+        });
+        std::vector<std::pair<int, int>> firstLabels;
+        int blockCount = 0, stringCount = 0;
+        for (const auto& entry : entries) {
+            firstLabels.push_back({ blockCount, stringCount });
+            blockCount += entry.blockCount;
+            stringCount += entry.stringCount;
+        }
+        runTasks(functionCount, [&](size_t i, unsigned) {
+            outputs[i] << relabel(entries[i].assembly, firstLabels[i].first, firstLabels[i].second);
+        });
+        cache->finish();
+        if (options.cacheStats) cache->printStatistics(diagnostics);
+    }
+    else {
+        int blockCount = 0, stringCount = 0;
+        for (const auto& cfg : cfgs) {
+            cfg->setFirstLabelNumbers(blockCount, stringCount);
+            blockCount += cfg->getBlockCount();
+            stringCount += cfg->getStringCount();
+        }
+
+        if (options.object) {
+            x86::Encoder encoder;
+            for (const auto& cfg : cfgs) cfg->generateFunctionsCode(encoder);
+            if (options.freestanding) IR::generateFreestandingRuntime(encoder);
+            encoder.finish();
+            std::ofstream ecriture(options.outputPath, std::ios::binary);
+            elf::writeObject(encoder, ecriture);
+            return 0;
+        }
+
+        runTasks(functionCount, [&](size_t i, unsigned) { cfgs[i]->generateFunctionsAsm(outputs[i]); });
+    }
+
+    size_t size = 0;
+    for (const auto& output : outputs) size += output.size();
+    IR::AsmBuffer assembly;
+    assembly.reserve(size);
+    for (const auto& output : outputs) assembly << output.view();
+    if (options.freestanding) IR::generateFreestandingRuntime(assembly);
+    timeReport.setOutputSize(assembly.size());
+    return writeAssembly(assembly, options, timeReport, diagnostics);
+}
+
+/*
+    --stream: the functions are parsed, checked, lowered and written one at a time, the tokens, the AST and the
+    graph of a function are released before the next one is parsed. Only the signatures of the functions are
+    kept, by the SymbolMapVisitor: a function can only call the functions defined before it (or itself),
+    so a single pass is enough. The memory is the one of the largest function rather than of the whole input.
+
+    The diagnostics and the output are the ones of a complete parse followed by the separate checks:
+    - after a syntax error, the messages of the checks are dropped and the output is removed
+    - after an error of the checks, the rest of the input is only parsed
+    - after an error of the IR generation, the rest of the input is only checked, the error comes after them
+    With -O, each function is optimized alone: the calls of pure functions are not evaluated at compile time,
+    the graphs of the callees are released.
+*/
+static int compileStreaming(const Options& options, antlr4::TokenSource& source, const antlr4::dfa::Vocabulary& vocabulary,
+    TimeReport& timeReport, std::ostream& diagnostics)
+{
+    timeReport.phase("streaming compilation", true);
+    std::ofstream output(options.outputPath, std::ios::binary);
+    if (!output) {
+        diagnostics << "error: cannot write file: " << options.outputPath.string() << std::endl;
+        return 1;
+    }
+
+    ast::TokenWindow tokens(&source);
+    ast::Parser parser(tokens, vocabulary, diagnostics);
+    std::ostringstream checkDiagnostics;
+    SymbolMapVisitor symbols(checkDiagnostics);
+    symbols.reset();
+    std::exception_ptr checkError, irError;
+    IR::AsmBuffer assembly;
+    size_t outputSize = 0;
+    int blockCount = 0, stringCount = 0;
+    IR::ArenaStatistics largestAST, largestIR;
+
+    while (auto program = parser.parseNextFunction()) {
+        tokens.discard();
+        if (checkError) continue;
+        const ast::Function& function = program->functions[0];
+        try {
+            ast::SymbolCheck(symbols).function(function);
+        }
+        catch (const CompileError&) {
+            checkError = std::current_exception();
+            continue;
+        }
+        if (irError) continue;
+
+        IR::ControlFlowGraph cfg(options);
+        try {
+            ast::CFGBuilder(cfg).function(function);
+        }
+        catch (const CompileError&) {
+            irError = std::current_exception();
+            continue;
+        }
+        if (options.optimize) cfg.optimize(std::set<std::string>());
+        if (program->arena.getStatistics().reserved > largestAST.reserved) largestAST = program->arena.getStatistics();
+        if (cfg.getArenaStatistics().reserved > largestIR.reserved) largestIR = cfg.getArenaStatistics();
+
+        cfg.setFirstLabelNumbers(blockCount, stringCount);
+        blockCount += cfg.getBlockCount();
+        stringCount += cfg.getStringCount();
+        cfg.generateFunctionsAsm(assembly);
+        assembly.write(output);
+        outputSize += assembly.size();
+        assembly.clear();
+    }
+
+    if (parser.getNumberOfSyntaxErrors() != 0 || checkError || irError) {
+        output.close();
+        std::error_code ignored;
+        if (std::filesystem::is_regular_file(options.outputPath, ignored)) std::filesystem::remove(options.outputPath, ignored); // not /dev/null
+        if (parser.getNumberOfSyntaxErrors() != 0) {
+            diagnostics << "error: syntax error during parsing" << std::endl;
+            return 1;
+        }
+        diagnostics << checkDiagnostics.str();
+        std::rethrow_exception(checkError ? checkError : irError);
+    }
+    diagnostics << checkDiagnostics.str();
+
+    if (options.freestanding) IR::generateFreestandingRuntime(assembly);
+    assembly.write(output);
+    outputSize += assembly.size();
+    timeReport.setOutputSize(outputSize);
+    output.close();
+    if (!output) {
+        diagnostics << "error: cannot write file: " << options.outputPath.string() << std::endl;
+        return 1;
+    }
+    if (options.memReport) {
+        diagnostics << "Token window: " << tokens.getMaxSize() << " tokens at most" << std::endl;
+        largestAST.print(diagnostics, "Largest function AST");
+        largestIR.print(diagnostics, "Largest function IR");
+    }
+    return 0;
+}
+
+// compilation of a translation unit, the errors which stop it are thrown as CompileError
+static int compileUnit(const Options& options, std::ostream& diagnostics)
+{
+    TimeReport timeReport(options.timeReport, diagnostics);
+
+    timeReport.phase("reading");
+    SourceFile source;
+    if (!source.open(options.inputPath)) {
+        diagnostics << "error: cannot read file: " << options.inputPath.string() << std::endl;
+        return 1;
+    }
+    std::string_view content = source.content();
+    timeReport.setInputSize(content.size());
+
+    // the hand-written lexer reads the content directly, ifccLexer is then only used for its vocabulary.
+    // ifccLexer reads an ASCII content directly too, the other ones are converted to UTF-32 by ANTLRInputStream
+    timeReport.phase("lexing", true);
+    std::unique_ptr<antlr4::CharStream> input;
+    if (options.handLexer) input = std::make_unique<antlr4::ANTLRInputStream>();
+    else if (source.isAscii()) input = std::make_unique<SourceCharStream>(content, options.inputPath.string());
+    else input = std::make_unique<antlr4::ANTLRInputStream>(content.data(), content.size());
+    ifccLexer lexer(input.get());
+    DiagnosticsErrorListener errorListener(diagnostics);
+    lexer.removeErrorListeners();
+    lexer.addErrorListener(&errorListener);
+    std::unique_ptr<ast::Lexer> handLexer;
+    if (options.handLexer) handLexer = std::make_unique<ast::Lexer>(content, lexer.getVocabulary(), diagnostics);
+    if (options.streaming) {
+        return compileStreaming(options, handLexer ? (antlr4::TokenSource&)*handLexer : (antlr4::TokenSource&)lexer, lexer.getVocabulary(),
+            timeReport, diagnostics);
+    }
+    auto tokens = std::make_unique<antlr4::CommonTokenStream>(handLexer ? (antlr4::TokenSource*)handLexer.get() : &lexer);
+    tokens->fill();
+
+    // the hand-written parser builds an AST, the ANTLR parser a parse tree
+    timeReport.phase("parsing", true);
+    std::unique_ptr<ast::Program> program;
+    std::unique_ptr<ifccParser> parser;
+    antlr4::tree::ParseTree* tree = nullptr;
+    size_t syntaxErrors;
+    if (options.handParser) {
+        ast::Parser handParser(*tokens, lexer.getVocabulary(), diagnostics);
+        program = handParser.parseProgram();
+        syntaxErrors = handParser.getNumberOfSyntaxErrors();
+    }
+    else {
+        parser = std::make_unique<ifccParser>(tokens.get());
+        tree = parseTwoStage(*parser, *tokens, options.fullLL, errorListener);
+        syntaxErrors = parser->getNumberOfSyntaxErrors();
+    }
+
+    if (syntaxErrors != 0) {
+        diagnostics << "error: syntax error during parsing" << std::endl;
+        return 1;
+    }
+
+    // the AST does not refer to the tokens nor to the source, they are only kept for the keys of the cache
+    if (program && options.cacheDirectory.empty()) {
+        tokens.reset();
+        handLexer.reset();
+        input.reset();
+        source.release();
+    }
+
+    /*
+    - SymbolMapVisitor parses the AST and checks variable usage using the symbol table
+    - CFGVisitor parses the AST and creates the CFG
+    - A call to a function of the CFG recursively generates the assembly code from the CFG
+    With the hand-written parser, ast::SymbolCheck and ast::CFGBuilder do the same on its AST.
+    */
+
+    // the interpreter and the JIT take the whole program in a single graph
+    bool parallel = (options.jobs > 1 || !options.cacheDirectory.empty()) && !options.interp && !options.run;
+
+    // --sema=fused: the checks are made by the walk generating the single graph, see CFGVisitor.h
+    SymbolMapVisitor symbolsVisitor(diagnostics);
+    bool fused = options.fusedSemantics && !parallel;
+    if (!fused) {
+        timeReport.phase("semantic analysis");
+        if (program) ast::SymbolCheck(symbolsVisitor).check(*program);
+        else symbolsVisitor.visit(tree);
+    }
+
+    auto buildCFG = [&](IR::ControlFlowGraph& cfg, SymbolMapVisitor* symbols) {
+        if (program) ast::CFGBuilder(cfg, symbols).build(*program);
+        else CFGVisitor(cfg, symbols).visit(tree);
+    };
+
+    if (parallel) {
+        std::vector<std::pair<size_t, size_t>> ranges;
+        if (program) {
+            for (const auto& function : program->functions) ranges.push_back({ function.firstToken, function.lastToken });
+            return compileFunctions(options, tokens.get(), ranges, [&](IR::ControlFlowGraph& cfg, size_t i) {
+                ast::CFGBuilder(cfg).function(program->functions[i]);
+            }, symbolsVisitor.getPureFunctions(), timeReport, diagnostics);
+        }
+        auto functions = static_cast<ifccParser::AxiomContext*>(tree)->prog()->function_def();
+        for (auto function : functions) ranges.push_back({ function->getStart()->getTokenIndex(), function->getStop()->getTokenIndex() });
+        return compileFunctions(options, tokens.get(), ranges, [&](IR::ControlFlowGraph& cfg, size_t i) {
+            CFGVisitor(cfg).visit(functions[i]);
+        }, symbolsVisitor.getPureFunctions(), timeReport, diagnostics);
+    }
+
+    timeReport.phase(fused ? "sema + IR (fused)" : "IR generation");
+    IR::ControlFlowGraph cfg(options);
+    buildCFG(cfg, fused ? &symbolsVisitor : nullptr);
+    if (options.interpCheck) {
+        // the same program without the optimizations, they must not change what it does
+        IR::ControlFlowGraph referenceCFG(options);
+        buildCFG(referenceCFG, nullptr);
+        cfg.optimize(symbolsVisitor.getPureFunctions());
+
+        timeReport.phase("execution");
+        std::stringstream stdinContent;
+        stdinContent << std::cin.rdbuf();
+        std::istringstream referenceIn(stdinContent.str()), optimizedIn(stdinContent.str());
+        std::ostringstream referenceOut, optimizedOut;
+        IR::Interpreter reference(referenceCFG, referenceIn, referenceOut);
+        IR::Interpreter optimized(cfg, optimizedIn, optimizedOut);
+        int referenceStatus, optimizedStatus;
+        bool referenceOk = reference.run("main", {}, referenceStatus);
+        bool optimizedOk = optimized.run("main", {}, optimizedStatus);
+        if (referenceOk != optimizedOk || reference.getError() != optimized.getError()
+            || referenceOut.str() != optimizedOut.str() || (referenceOk && referenceStatus != optimizedStatus)) {
+            diagnostics << "error: the optimized program behaves differently: returned " << optimizedStatus << " instead of " << referenceStatus
+                << ", printed " << optimizedOut.str().size() << " bytes instead of " << referenceOut.str().size() << std::endl;
+            return 1;
+        }
+        std::cout << optimizedOut.str();
+        if (!optimizedOk) {
+            diagnostics << "error: " << optimized.getError() << std::endl;
+            return 1;
+        }
+        return optimizedStatus;
+    }
+    if (options.optimize) {
+        timeReport.phase("optimization");
+        cfg.optimize(symbolsVisitor.getPureFunctions());
+    }
+    if (options.memReport) {
+        if (program) program->arena.getStatistics().print(diagnostics, "AST");
+        cfg.getArenaStatistics().print(diagnostics);
+    }
+
+    if (options.interp) {
+        timeReport.phase("execution");
+        IR::Interpreter interpreter(cfg, std::cin, std::cout);
+        int status;
+        if (!interpreter.run("main", {}, status)) {
+            std::cout.flush();
+            diagnostics << "error: " << interpreter.getError() << std::endl;
+            return 1;
+        }
+        std::cout.flush();
+        return status;
+    }
+
+    timeReport.phase("code generation");
+    if (options.run) {
+        x86::Encoder encoder;
+        cfg.generateCode(encoder);
+        encoder.finish();
+        x86::Jit jit(encoder);
+        jit.bindSymbol("putchar", (void*)&putchar);
+        jit.bindSymbol("getchar", (void*)&getchar);
+        jit.bindSymbol("fwrite", (void*)&fwrite);
+        jit.bindSymbol("stdout", (void*)&stdout);
+        jit.load();
+        timeReport.phase("execution");
+        if (!jit.getSymbol("main")) {
+            diagnostics << "error: no main function to run" << std::endl;
+            return 1;
+        }
+        int status = jit.call("main");
+        fflush(stdout);
+        return status;
+    }
+
+    if (options.object) {
+        x86::Encoder encoder;
+        cfg.generateCode(encoder);
+        encoder.finish();
+        std::ofstream ecriture(options.outputPath, std::ios::binary);
+        elf::writeObject(encoder, ecriture);
+        return 0;
+    }
+
+    IR::AsmBuffer assembly;
+    cfg.generateAsm(assembly);
+    timeReport.setOutputSize(assembly.size());
+    return writeAssembly(assembly, options, timeReport, diagnostics);
+}
+
+/*
+    The chains of binary operators are walked with work stacks (see ExpressionChain.h), but the nested statements,
+    parentheses, unary operators and assignments are still walked recursively, by the parsers too. The unit is
+    compiled on a thread with a large stack, whose pages are only committed when they are used: the nesting depth
+    it allows is about a hundred times the one of the 8 MB of the main thread.
+*/
+static const size_t COMPILE_STACK_SIZE = size_t(1) << 30;
+
+static void runOnLargeStack(const std::function<void()>& task)
+{
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setstacksize(&attributes, COMPILE_STACK_SIZE);
+    pthread_t thread;
+    auto run = [](void* argument) -> void* {
+        (*static_cast<const std::function<void()>*>(argument))();
+        return nullptr;
+    };
+    if (pthread_create(&thread, &attributes, run, (void*)&task) == 0) pthread_join(thread, nullptr);
+    else task(); // on the current stack
+    pthread_attr_destroy(&attributes);
+}
+
+int compileFile(const Options& options, std::ostream& diagnostics)
+{
+    int status = 1;
+    std::exception_ptr exception;
+    runOnLargeStack([&]() {
+        Interner interner; // the names of the unit are freed with it
+        InternerScope scope(interner);
+        try {
+            status = compileUnit(options, diagnostics);
+        }
+        catch (const CompileError& error) {
+            diagnostics << "error: " << error.what() << std::endl;
+            status = 1;
+        }
+        catch (...) {
+            exception = std::current_exception(); // rethrown on the calling thread
+        }
+    });
+    if (exception) std::rethrow_exception(exception);
+    return status;
+}
+
+/*
+    The workers take the next input until there is none left. The diagnostics of each input are
+    buffered and printed in the order of the inputs, each line prefixed with the path of the input.
+*/
+int compileFiles(const Options& options, std::ostream& output)
+{
+    const auto& inputs = options.inputPaths;
+    std::vector<int> statuses(inputs.size());
+    std::vector<std::string> diagnostics(inputs.size());
+    std::vector<bool> done(inputs.size(), false);
+    std::atomic<size_t> nextInput(0);
+    std::mutex printMutex;
+    size_t nextPrinted = 0;
+
+    auto worker = [&]() {
+        for (size_t i = nextInput++; i < inputs.size(); i = nextInput++) {
+            Options unitOptions = options;
+            unitOptions.inputPath = inputs[i];
+            unitOptions.jobs = 1; // the threads already compile the other inputs
+            unitOptions.outputPath = options.outputPath / inputs[i].filename().replace_extension(options.object ? ".o" : ".s");
+            std::ostringstream unitDiagnostics;
+            int status = 1;
+            // an error of the compiler only fails its unit, like a CompileError, and the other units go on
+            try {
+                status = compileFile(unitOptions, unitDiagnostics);
+            }
+            catch (const std::exception& error) {
+                unitDiagnostics << "error: " << error.what() << std::endl;
+            }
+
+            std::lock_guard<std::mutex> lock(printMutex);
+            statuses[i] = status;
+            diagnostics[i] = unitDiagnostics.str();
+            done[i] = true;
+            for (; nextPrinted < inputs.size() && done[nextPrinted]; ++nextPrinted) {
+                std::istringstream lines(diagnostics[nextPrinted]);
+                for (std::string line; std::getline(lines, line);)
+                    output << inputs[nextPrinted].string() << ": " << line << std::endl;
+                diagnostics[nextPrinted].clear();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned j = 1; j < options.jobs && j < inputs.size(); ++j) workers.emplace_back(worker);
+    worker();
+    for (auto& thread : workers) thread.join();
+
+    size_t failed = 0;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (statuses[i] == 0) continue;
+        output << inputs[i].string() << ": exit status " << statuses[i] << std::endl;
+        ++failed;
+    }
+    if (failed) output << "error: " << failed << " of " << inputs.size() << " files failed to compile" << std::endl;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <iostream>
+#include "Options.h"
+
+// Compiles options.inputPath to options.outputPath, the diagnostics are written on `diagnostics`. Returns the exit status
+// With options.jobs > 1, the functions of the input are compiled in parallel
+int compileFile(const Options& options, std::ostream& diagnostics);
+
+// Compiles all the options.inputPaths into the directory options.outputPath on options.jobs threads,
+// the diagnostics of the inputs are written on `diagnostics`
+int compileFiles(const Options& options, std::ostream& diagnostics);
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+#include "antlr4-runtime.h"
+#include "generated/ifccParser.h"
+
+/*
+    A chain of left associative operators `a + b - c + ...` is a left-deep tree, as deep as the number of terms:
+    a walk recursing on both operands would overflow the native stack on a generated expression of a million terms.
+    The walks of the expressions (CFGVisitor, SymbolMapVisitor, and ast::CFGBuilder on the AST)
+    take the left operands of a chain in a loop instead: the binary operators of the left spine are pushed on a
+    work stack, the first operand is visited, then the operators are completed from the innermost one with their
+    right operand, which is the order of the recursive walk.
+    The right operands of a chain only recurse on parentheses and operators of higher precedence.
+*/
+
+// the binary alternatives of `expression` are the ones with an expression on both sides of the operator
+inline bool isBinaryExpression(antlr4::tree::ParseTree* node)
+{
+    return node->children.size() == 3 && dynamic_cast<ifccParser::ExpressionContext*>(node->children[0])
+        && dynamic_cast<ifccParser::ExpressionContext*>(node->children[2]);
+}
+
+inline ifccParser::ExpressionContext* rightOperand(ifccParser::ExpressionContext* binary)
+{
+    return dynamic_cast<ifccParser::ExpressionContext*>(binary->children[2]);
+}
+
+// Pushes the binary operators of the left spine of `ctx` on `chain`, the outermost first, and returns the first
+// operand of the chain. The parentheses of the spine, which are not operators, are skipped.
+inline ifccParser::ExpressionContext* leftChain(ifccParser::ExpressionContext* ctx, std::vector<ifccParser::ExpressionContext*>& chain)
+{
+    while (true) {
+        if (auto parenthesis = dynamic_cast<ifccParser::Expr_arithmetic_parContext*>(ctx)) ctx = parenthesis->expression();
+        else if (isBinaryExpression(ctx)) {
+            chain.push_back(ctx);
+            ctx = dynamic_cast<ifccParser::ExpressionContext*>(ctx->children[0]);
+        }
+        else return ctx;
+    }
+}
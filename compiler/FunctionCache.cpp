@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "FunctionCache.h"
+
+// ---------------------------------------------------------------- SHA-256 (FIPS 180-4)
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+static void sha256Block(uint32_t h[8], const unsigned char* block)
+{
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i)
+        w[i] = (uint32_t)block[4 * i] << 24 | (uint32_t)block[4 * i + 1] << 16 | (uint32_t)block[4 * i + 2] << 8 | block[4 * i + 3];
+    for (int i = 16; i < 64; ++i) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], k = h[7];
+    for (int i = 0; i < 64; ++i) {
+        uint32_t t1 = k + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        k = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+}
+
+static std::string sha256(const std::string& data)
+{
+    uint32_t h[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+    size_t full = data.size() / 64 * 64;
+    for (size_t i = 0; i < full; i += 64) sha256Block(h, (const unsigned char*)data.data() + i);
+
+    // padding: 0x80, zeros, then the length in bits on 64 bits
+    unsigned char tail[128] = { 0 };
+    size_t rest = data.size() - full;
+    memcpy(tail, data.data() + full, rest);
+    tail[rest] = 0x80;
+    size_t tailSize = rest + 9 <= 64 ? 64 : 128;
+    uint64_t bits = (uint64_t)data.size() * 8;
+    for (int i = 0; i < 8; ++i) tail[tailSize - 1 - i] = (unsigned char)(bits >> (8 * i));
+    for (size_t i = 0; i < tailSize; i += 64) sha256Block(h, tail + i);
+
+    std::ostringstream hex;
+    for (uint32_t word : h) hex << std::hex << std::setw(8) << std::setfill('0') << word;
+    return hex.str();
+}
+
+// ---------------------------------------------------------------- cache
+
+FunctionCache::FunctionCache(const std::filesystem::path& directory, uint64_t maxSize)
+    : _directory(directory), _maxSize(maxSize), _hits(0), _misses(0), _storedBytes(0),
+    _totalHits(0), _totalMisses(0), _totalEvictions(0), _size(0)
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+}
+
+std::string FunctionCache::key(const std::string& content)
+{
+    return sha256(content);
+}
+
+std::string FunctionCache::compilerIdentity()
+{
+    struct stat info;
+    if (stat("/proc/self/exe", &info) != 0) return "unknown";
+    return std::to_string(info.st_size) + " " + std::to_string(info.st_mtim.tv_sec) + "." + std::to_string(info.st_mtim.tv_nsec);
+}
+
+std::filesystem::path FunctionCache::path(const std::string& key) const
+{
+    return _directory / key.substr(0, 2) / (key.substr(2) + ".s");
+}
+
+bool FunctionCache::load(const std::string& key, Entry& entry)
+{
+    std::filesystem::path file = path(key);
+    std::ifstream in(file, std::ios::binary);
+    std::string header;
+    if (in.good() && std::getline(in, header) && sscanf(header.c_str(), "%d %d", &entry.blockCount, &entry.stringCount) == 2) {
+        std::ostringstream assembly;
+        assembly << in.rdbuf();
+        entry.assembly = assembly.str();
+        utimensat(AT_FDCWD, file.c_str(), nullptr, 0); // most recently used
+        ++_hits;
+        return true;
+    }
+    ++_misses;
+    return false;
+}
+
+void FunctionCache::store(const std::string& key, const Entry& entry)
+{
+    std::filesystem::path file = path(key);
+    std::error_code error;
+    std::filesystem::create_directories(file.parent_path(), error);
+
+    // written next to the entry then renamed, the readers never see a partial entry
+    std::ostringstream temporary;
+    temporary << file.string() << ".tmp" << getpid() << "-" << std::hash<std::thread::id>()(std::this_thread::get_id());
+    {
+        std::ofstream out(temporary.str(), std::ios::binary);
+        out << entry.blockCount << " " << entry.stringCount << "\n" << entry.assembly;
+        if (!out.good()) return;
+    }
+    if (rename(temporary.str().c_str(), file.c_str()) != 0) {
+        unlink(temporary.str().c_str());
+        return;
+    }
+    _storedBytes += entry.assembly.size();
+}
+
+void FunctionCache::finish()
+{
+    std::string statsPath = (_directory / "stats").string();
+    int fd = open(statsPath.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return;
+    flock(fd, LOCK_EX);
+
+    std::string content(64, '\0');
+    ssize_t n = pread(fd, &content[0], content.size() - 1, 0);
+    unsigned long long hits = 0, misses = 0, evictions = 0, size = 0;
+    if (n > 0) sscanf(content.c_str(), "%llu %llu %llu %llu", &hits, &misses, &evictions, &size);
+    _totalHits = hits + _hits;
+    _totalMisses = misses + _misses;
+    _totalEvictions = evictions;
+    _size = size + _storedBytes;
+    if (_size > _maxSize) evict(_size, _totalEvictions);
+
+    std::ostringstream stats;
+    stats << _totalHits << " " << _totalMisses << " " << _totalEvictions << " " << _size << "\n";
+    if (ftruncate(fd, 0) == 0) pwrite(fd, stats.str().data(), stats.str().size(), 0);
+    flock(fd, LOCK_UN);
+    close(fd);
+}
+
+// removes the least recently used entries until the cache is at 90% of its size, the size is recomputed
+void FunctionCache::evict(uint64_t& size, uint64_t& evictions)
+{
+    struct File {
+        std::filesystem::file_time_type time;
+        uint64_t size;
+        std::filesystem::path path;
+    };
+    std::vector<File> files;
+    size = 0;
+    std::error_code error;
+    for (auto it = std::filesystem::recursive_directory_iterator(_directory, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+        if (!it->is_regular_file(error) || it->path().extension() != ".s") continue;
+        File file{ it->last_write_time(error), it->file_size(error), it->path() };
+        size += file.size;
+        files.push_back(file);
+    }
+    std::sort(files.begin(), files.end(), [](const File& a, const File& b) { return a.time < b.time; });
+    for (const auto& file : files) {
+        if (size <= _maxSize / 10 * 9) break;
+        if (!std::filesystem::remove(file.path, error)) continue;
+        size -= file.size;
+        ++evictions;
+    }
+}
+
+void FunctionCache::printStatistics(std::ostream& o) const
+{
+    uint64_t lookups = _hits + _misses;
+    o << "cache: " << _hits << " hits, " << _misses << " misses";
+    if (lookups) o << " (" << std::fixed << std::setprecision(1) << 100.0 * _hits / lookups << "% hits)";
+    o << std::endl;
+    o << "cache total: " << _totalHits << " hits, " << _totalMisses << " misses, " << _totalEvictions << " evictions, "
+        << _size / 1024 << " KiB of " << _maxSize / 1024 << " KiB in " << _directory.string() << std::endl;
+}
+
+// ---------------------------------------------------------------- labels
+
+// The labels are the only words starting with ".L" in the generated code, except in the text of the strings
+std::string relabel(const std::string& assembly, int firstBlock, int firstString)
+{
+    if (firstBlock == 0 && firstString == 0) return assembly;
+    std::string result;
+    result.reserve(assembly.size() + assembly.size() / 16);
+    for (size_t i = 0; i < assembly.size();) {
+        if (assembly.compare(i, 8, "\t.ascii\t") == 0) {
+            size_t end = assembly.find('\n', i);
+            end = end == std::string::npos ? assembly.size() : end + 1;
+            result.append(assembly, i, end - i);
+            i = end;
+            continue;
+        }
+        bool wordStart = i == 0 || !(isalnum((unsigned char)assembly[i - 1]) || assembly[i - 1] == '_' || assembly[i - 1] == '.');
+        if (wordStart && assembly.compare(i, 2, ".L") == 0) {
+            bool string = assembly.compare(i + 2, 3, "str") == 0;
+            size_t digits = i + (string ? 5 : 2), end = digits;
+            while (end < assembly.size() && isdigit((unsigned char)assembly[end])) ++end;
+            if (end > digits) {
+                result += string ? ".Lstr" : ".L";
+                result += std::to_string(std::stoi(assembly.substr(digits, end - digits)) + (string ? firstString : firstBlock));
+                i = end;
+                continue;
+            }
+        }
+        result += assembly[i++];
+    }
+    return result;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+/*
+    Cache of the assembly of the functions on disk (--cache=DIR), content-addressed: the key of a function is
+    the SHA-256 of its tokens, of the options changing the generated code and of the compiler itself (see key()).
+
+    An entry is the assembly of the function generated alone, its labels numbered from 0, with the numbers of
+    block and string labels it uses: the driver shifts the labels after the ones of the functions before it
+    (see relabel()), so the output is the same as without the cache.
+
+    Entries are files named after their key, written atomically. The hits update the date of their file and
+    the least recently used entries are evicted when the cache exceeds its size. The statistics and the size
+    of the cache are kept in DIR/stats, updated under a lock since several compilers may share the directory.
+*/
+class FunctionCache {
+public:
+    struct Entry {
+        int blockCount;
+        int stringCount;
+        std::string assembly;
+    };
+
+    FunctionCache(const std::filesystem::path& directory, uint64_t maxSize);
+
+    // key of the content of a function, which must contain everything the generated code depends on
+    static std::string key(const std::string& content);
+    // size and date of the executable of the compiler, a new build does not use the entries of the previous one
+    static std::string compilerIdentity();
+
+    // load and store can be called by several threads
+    bool load(const std::string& key, Entry& entry); // true on a hit
+    void store(const std::string& key, const Entry& entry);
+
+    // Adds the statistics of this compilation to the ones of the cache and evicts entries if needed
+    void finish();
+    void printStatistics(std::ostream& o) const;
+
+private:
+    std::filesystem::path path(const std::string& key) const;
+    void evict(uint64_t& size, uint64_t& evictions);
+
+    std::filesystem::path _directory;
+    uint64_t _maxSize;
+    std::atomic<uint64_t> _hits, _misses, _storedBytes;
+    // statistics of the cache after finish()
+    uint64_t _totalHits, _totalMisses, _totalEvictions, _size;
+};
+
+// Shifts the labels .L<n> and .Lstr<n> of the assembly of a function by firstBlock and firstString
+std::string relabel(const std::string& assembly, int firstBlock, int firstString);
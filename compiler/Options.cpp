@@ -0,0 +1,178 @@
+#include <iostream>
+#include <string>
+#include <set>
+#include <algorithm>
+#include <cstdlib>
+#include <cerrno>
+#include <cstdint>
+#include <thread>
+#include <unistd.h>
+#include "Options.h"
+
+// -j N is limited to this number of threads per core, N can also come from a client of the daemon
+static const unsigned JOBS_PER_CORE = 4;
+
+// a positive decimal number, false if it has other characters or is above max
+static bool parseNumber(const std::string& text, uint64_t max, uint64_t& value)
+{
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) return false;
+    errno = 0;
+    unsigned long long number = strtoull(text.c_str(), nullptr, 10);
+    if (errno == ERANGE || number == 0 || number > max) return false;
+    value = number;
+    return true;
+}
+
+static bool usage(std::ostream& diagnostics)
+{
+    diagnostics << "usage: ifcc INPUT... | - [-o OUTPUT] [-j N] [-c | --run | --interp | --interp-check] [-O] [--profile] [--buffered-io] [-ffreestanding] [--parser=antlr|antlr-ll|hand] [--lexer=antlr|hand] [--sema=separate|fused] [--stream] [--ir=dense|objects] [-ftime-report] [-fmem-report] [--cache=DIR [--cache-size=MB] [--cache-stats]] [--dfa=FILE|none] [--dfa-save=FILE] [--connect [--socket=PATH]]" << std::endl;
+    diagnostics << "       ifcc --daemon [--socket=PATH]" << std::endl;
+    return false;
+}
+
+Options parseOptions(int argc, char* const* argv)
+{
+    Options options;
+    if (!parseOptions(std::vector<std::string>(argv + 1, argv + argc), options, std::cerr)) exit(1);
+    return options;
+}
+
+bool parseOptions(const std::vector<std::string>& args, Options& options, std::ostream& diagnostics, const std::filesystem::path& directory)
+{
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if (arg == "-o") {
+            if (i + 1 >= args.size()) return usage(diagnostics);
+            options.outputPath = directory / args[++i];
+        }
+        else if (arg == "-j" || (arg.rfind("-j", 0) == 0 && arg.size() > 2)) {
+            if (arg == "-j" && i + 1 >= args.size()) return usage(diagnostics);
+            uint64_t jobs;
+            if (!parseNumber(arg == "-j" ? args[++i] : arg.substr(2), UINT64_MAX, jobs)) return usage(diagnostics);
+            options.jobs = (unsigned)std::min<uint64_t>(jobs, std::max(std::thread::hardware_concurrency(), 1u) * JOBS_PER_CORE);
+        }
+        else if (arg == "--daemon") options.daemon = true;
+        else if (arg == "--connect") options.connect = true;
+        else if (arg.rfind("--socket=", 0) == 0 && arg.size() > 9) options.socketPath = directory / arg.substr(9);
+        else if (arg.rfind("--cache=", 0) == 0 && arg.size() > 8) options.cacheDirectory = directory / arg.substr(8);
+        else if (arg.rfind("--cache-size=", 0) == 0) {
+            uint64_t size;
+            if (!parseNumber(arg.substr(13), UINT64_MAX >> 20, size)) return usage(diagnostics);
+            options.cacheSize = size << 20;
+        }
+        else if (arg == "--cache-stats") options.cacheStats = true;
+        else if (arg == "--dfa=none") options.dfaPath.clear();
+        else if (arg.rfind("--dfa=", 0) == 0 && arg.size() > 6) options.dfaPath = directory / arg.substr(6);
+        else if (arg.rfind("--dfa-save=", 0) == 0 && arg.size() > 11) options.dfaSavePath = directory / arg.substr(11);
+        else if (arg == "-c") options.object = true;
+        else if (arg == "--run") options.run = true;
+        else if (arg == "--interp") options.interp = true;
+        else if (arg == "--interp-check") options.interp = options.interpCheck = true;
+        else if (arg == "--parser=antlr") options.handParser = options.fullLL = false;
+        else if (arg == "--parser=antlr-ll") {
+            options.handParser = false;
+            options.fullLL = true;
+        }
+        else if (arg == "--parser=hand") {
+            options.handParser = true;
+            options.fullLL = false;
+        }
+        else if (arg == "--lexer=antlr") options.handLexer = false;
+        else if (arg == "--lexer=hand") options.handLexer = true;
+        else if (arg == "--sema=separate") options.fusedSemantics = false;
+        else if (arg == "--sema=fused") options.fusedSemantics = true;
+        else if (arg == "--stream") options.streaming = true;
+        else if (arg == "--ir=dense") options.objectIR = false;
+        else if (arg == "--ir=objects") options.objectIR = true;
+        else if (arg == "-ftime-report") options.timeReport = true;
+        else if (arg == "-fmem-report") options.memReport = true;
+        else if (arg == "-O") options.optimize = true;
+        else if (arg == "--profile") options.profile = true;
+        else if (arg == "--buffered-io") options.bufferedIO = true;
+        else if (arg == "-ffreestanding" || arg == "-nostdlib") options.freestanding = options.bufferedIO = true;
+        else if (arg == "-") options.inputPaths.push_back(arg); // the standard input
+        else if (!arg.empty() && arg[0] != '-') options.inputPaths.push_back(directory / arg);
+        else return usage(diagnostics);
+    }
+    if (options.socketPath.empty()) options.socketPath = defaultSocketPath();
+    if (options.daemon) {
+        if (!options.inputPaths.empty() || options.connect) {
+            diagnostics << "error: --daemon takes no input, the inputs are sent by the clients (--connect)" << std::endl;
+            return false;
+        }
+        return true;
+    }
+    if (options.inputPaths.empty()) return usage(diagnostics);
+    if (options.freestanding && options.profile) {
+        diagnostics << "error: --profile needs the C library and cannot be used with -ffreestanding" << std::endl;
+        return false;
+    }
+    if (options.run && (options.profile || options.bufferedIO || options.object)) {
+        diagnostics << "error: --run executes the program with the I/O of the compiler and cannot be used with -c, --profile, --buffered-io or -ffreestanding" << std::endl;
+        return false;
+    }
+    if (options.interp && (options.run || options.object || options.profile)) {
+        diagnostics << "error: --interp and --interp-check cannot be used with -c, --run or --profile" << std::endl;
+        return false;
+    }
+    if (!options.cacheDirectory.empty() && (options.object || options.run || options.interp)) {
+        diagnostics << "error: the cache stores assembly, --cache cannot be used with -c, --run, --interp or --interp-check" << std::endl;
+        return false;
+    }
+    if (options.streaming && (!options.handParser || options.object || options.run || options.interp || !options.cacheDirectory.empty())) {
+        diagnostics << "error: --stream writes the assembly of each function with the hand-written parser, it needs --parser=hand and cannot be used with -c, --run, --interp, --interp-check or --cache" << std::endl;
+        return false;
+    }
+    if (!options.dfaSavePath.empty() && (options.handParser || options.connect)) {
+        diagnostics << "error: --dfa-save writes the DFA of the ANTLR parser of this process, it cannot be used with --parser=hand or --connect" << std::endl;
+        return false;
+    }
+    if (options.connect && (options.run || options.interp)) {
+        diagnostics << "error: --run, --interp and --interp-check execute the program in the compiler and cannot be used with --connect" << std::endl;
+        return false;
+    }
+
+    bool standardInput = std::count(options.inputPaths.begin(), options.inputPaths.end(), "-") > 0;
+    if (standardInput && (options.inputPaths.size() > 1 || options.connect)) {
+        diagnostics << "error: the standard input (-) must be the only input, and cannot be sent to the server" << std::endl;
+        return false;
+    }
+
+    if (options.inputPaths.size() > 1) {
+        if (options.run || options.interp) {
+            diagnostics << "error: --run, --interp and --interp-check execute a single input" << std::endl;
+            return false;
+        }
+        // the outputs are named after the inputs in the output directory, they must not overwrite each other
+        std::set<std::filesystem::path> outputs;
+        for (const auto& input : options.inputPaths) {
+            if (!outputs.insert(input.filename().replace_extension()).second) {
+                diagnostics << "error: several inputs are named " << input.filename().replace_extension().string() << std::endl;
+                return false;
+            }
+        }
+        if (options.outputPath.empty()) options.outputPath = directory;
+        if (!options.outputPath.empty()) {
+            std::error_code error;
+            std::filesystem::create_directories(options.outputPath, error);
+            if (!std::filesystem::is_directory(options.outputPath)) {
+                diagnostics << "error: the output of several inputs must be a directory: " << options.outputPath.string() << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    options.inputPath = options.inputPaths[0];
+    if (options.outputPath.empty() && standardInput) options.outputPath = directory / (options.object ? "stdin.o" : "stdin.s");
+    if (options.outputPath.empty())
+        options.outputPath = directory / std::filesystem::path(options.inputPath).filename().replace_extension(options.object ? ".o" : ".s");
+    return true;
+}
+
+std::filesystem::path defaultSocketPath()
+{
+    const char* runtimeDirectory = getenv("XDG_RUNTIME_DIR");
+    if (runtimeDirectory && *runtimeDirectory) return std::filesystem::path(runtimeDirectory) / "ifcc.sock";
+    return "/tmp/ifcc-" + std::to_string(getuid()) + ".sock";
+}
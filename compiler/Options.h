@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Command line options of ifcc, read by the driver, the visitors and the IR
+struct Options {
+    std::filesystem::path inputPath;
+    std::filesystem::path outputPath; // the output directory when there are several inputs
+    std::vector<std::filesystem::path> inputPaths; // several inputs are compiled in one process (see Driver.h)
+    unsigned jobs = 1; // -j N : number of threads compiling the inputs, or the functions of a single input
+    bool daemon = false; // --daemon : compile server listening on socketPath (see Server.h)
+    bool connect = false; // --connect : sends the compilation to the server listening on socketPath
+    std::filesystem::path socketPath; // --socket=PATH : Unix socket of the server, defaultSocketPath() by default
+    std::filesystem::path cacheDirectory; // --cache=DIR : cache of the assembly of the functions (see FunctionCache.h)
+    uint64_t cacheSize = 256 << 20; // --cache-size=MB : size of the cache, the least recently used functions are evicted
+    bool cacheStats = false; // --cache-stats : prints the hits and misses of the cache
+    std::filesystem::path dfaPath; // --dfa=FILE : DFA of the ANTLR parser loaded at startup (see DfaSnapshot.h), none by default or with --dfa=none
+    std::filesystem::path dfaSavePath; // --dfa-save=FILE : writes the DFA of the ANTLR parser after the compilation, to train a snapshot
+
+    bool profile = false; // --profile : every function counts its calls and cycles (see runtime/ifcc_profile.c)
+    bool object = false; // -c : writes an ELF object file with the machine code instead of assembly
+    bool run = false; // --run : compiles in memory and executes main in the compiler process, which exits with its return value
+    bool interp = false; // --interp : executes the IR with the interpreter, ifcc exits with the return value of main
+    bool interpCheck = false; // --interp-check : interprets the IR before and after the optimizations and compares the outputs (implies interp)
+    bool handParser = false; // --parser=hand : hand-written parser building the AST of ast/Ast.h (--parser=antlr by default)
+    bool fullLL = false; // --parser=antlr-ll : ANTLR parser with full LL prediction only, without the SLL first stage
+    bool handLexer = false; // --lexer=hand : hand-written lexer of ast/Lexer.h instead of ifccLexer (--lexer=antlr by default)
+    bool fusedSemantics = false; // --sema=fused : the semantic checks are made while generating the IR instead of a separate walk (--sema=separate by default)
+    bool streaming = false; // --stream : the functions are parsed, checked, lowered and written one at a time with the hand-written parser (see Driver.cpp)
+    bool objectIR = false; // --ir=objects : assembly written by the virtual generateAsm of the instructions instead of the dense IR of ir/DenseIR.h (--ir=dense by default)
+    bool timeReport = false; // -ftime-report : prints the time spent in each phase
+    bool memReport = false; // -fmem-report : prints the allocations of the IR (see ir/Arena.h)
+    bool optimize = false; // -O : runs the optimization passes on the IR
+    bool bufferedIO = false; // --buffered-io : putchar and getchar use the buffers of runtime/ifcc_io.c
+    bool freestanding = false; // -ffreestanding, -nostdlib : the output defines _start and its own I/O on syscalls (implies bufferedIO)
+};
+
+// Parses the command line. Prints the usage and exits if the arguments are invalid
+Options parseOptions(int argc, char* const* argv);
+
+// The same without exiting: returns false after writing the usage or the error on `diagnostics`.
+// The relative paths are relative to `directory` (the working directory of a client of the server)
+bool parseOptions(const std::vector<std::string>& args, Options& options, std::ostream& diagnostics, const std::filesystem::path& directory = {});
+
+// $XDG_RUNTIME_DIR/ifcc.sock, or /tmp/ifcc-UID.sock without XDG_RUNTIME_DIR
+std::filesystem::path defaultSocketPath();
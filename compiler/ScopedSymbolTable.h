@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Symbol.h"
+
+/*
+    Symbol table with nested scopes, used by the semantic analysis (SymbolMapVisitor) and by the IR generation
+    (ControlFlowGraph) with their own values.
+
+    The bindings of all the open scopes are kept in a stack, and an open-addressing hash table (linear probing)
+    gives the innermost binding of each symbol: a lookup costs one probe whatever the depth of the scopes.
+    A binding remembers the one it shadows, which is restored in the table when its scope is popped.
+    The symbols are never removed from the hash table, they only lose their binding.
+*/
+template <typename T>
+class ScopedSymbolTable {
+public:
+    struct Binding {
+        Symbol symbol;
+        T value;
+        uint32_t shadowed; // index of the binding hidden by this one, NONE if none
+        uint32_t depth; // number of scopes open when it was declared
+    };
+
+    ScopedSymbolTable() : _slots(16, Slot{ EMPTY, NONE }), _used(0) {}
+
+    void pushScope() { _scopes.push_back(_bindings.size()); }
+    void popScope() {
+        size_t begin = _scopes.back();
+        _scopes.pop_back();
+        while (_bindings.size() > begin) {
+            find(_bindings.back().symbol)->binding = _bindings.back().shadowed;
+            _bindings.pop_back();
+        }
+    }
+    inline size_t depth() const { return _scopes.size(); }
+
+    // Binds the symbol in the innermost scope. Returns false if it was already declared in this scope
+    // (the new binding hides the previous one anyway)
+    bool declare(Symbol symbol, const T& value) {
+        Slot& slot = insert(symbol);
+        bool redeclared = slot.binding != NONE && _bindings[slot.binding].depth == depth();
+        _bindings.push_back(Binding{ symbol, value, slot.binding, (uint32_t)depth() });
+        slot.binding = (uint32_t)_bindings.size() - 1;
+        return !redeclared;
+    }
+
+    // value of the innermost binding of the symbol, nullptr if it is not declared in the open scopes
+    T* lookup(Symbol symbol) {
+        Slot* slot = find(symbol);
+        return slot && slot->binding != NONE ? &_bindings[slot->binding].value : nullptr;
+    }
+
+    // the bindings of the innermost scope, in the order of their declarations
+    inline typename std::vector<Binding>::const_iterator scopeBegin() const { return _bindings.begin() + (_scopes.empty() ? 0 : _scopes.back()); }
+    inline typename std::vector<Binding>::const_iterator scopeEnd() const { return _bindings.end(); }
+
+    void clear() {
+        _slots.assign(16, Slot{ EMPTY, NONE });
+        _used = 0;
+        _bindings.clear();
+        _scopes.clear();
+    }
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+    static constexpr Symbol EMPTY = UINT32_MAX; // never returned by intern
+
+    struct Slot {
+        Symbol symbol;
+        uint32_t binding; // innermost binding, NONE if the symbol is not declared in the open scopes
+    };
+
+    // multiplicative hashing, the size of _slots is a power of 2
+    inline size_t index(Symbol symbol) const { return (size_t)(symbol * 2654435769u) & (_slots.size() - 1); }
+
+    Slot* find(Symbol symbol) {
+        for (size_t i = index(symbol);; i = (i + 1) & (_slots.size() - 1)) {
+            if (_slots[i].symbol == symbol) return &_slots[i];
+            if (_slots[i].symbol == EMPTY) return nullptr;
+        }
+    }
+
+    Slot& insert(Symbol symbol) {
+        if (2 * (_used + 1) > _slots.size()) grow();
+        size_t i = index(symbol);
+        while (_slots[i].symbol != symbol && _slots[i].symbol != EMPTY) i = (i + 1) & (_slots.size() - 1);
+        if (_slots[i].symbol == EMPTY) {
+            _slots[i].symbol = symbol;
+            ++_used;
+        }
+        return _slots[i];
+    }
+
+    void grow() {
+        std::vector<Slot> slots(2 * _slots.size(), Slot{ EMPTY, NONE });
+        slots.swap(_slots);
+        for (const Slot& slot : slots) {
+            if (slot.symbol == EMPTY) continue;
+            size_t i = index(slot.symbol);
+            while (_slots[i].symbol != EMPTY) i = (i + 1) & (_slots.size() - 1);
+            _slots[i] = slot;
+        }
+    }
+
+    std::vector<Slot> _slots;
+    size_t _used; // slots holding a symbol
+    std::vector<Binding> _bindings;
+    std::vector<size_t> _scopes; // index of the first binding of each open scope
+};
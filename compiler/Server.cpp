@@ -0,0 +1,226 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Server.h"
+#include "Driver.h"
+
+/*
+    Protocol, one request per connection:
+    - the client sends its working directory then its arguments, each terminated by '\0', and shuts down its side
+    - the server answers with the exit status on a line, followed by the diagnostics until the end of the connection
+*/
+
+static volatile sig_atomic_t stopping = 0;
+
+static void stop(int)
+{
+    stopping = 1;
+}
+
+static bool writeAll(int fd, const std::string& data)
+{
+    for (size_t written = 0; written < data.size();) {
+        ssize_t n = write(fd, data.data() + written, data.size() - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        written += n;
+    }
+    return true;
+}
+
+static bool readAll(int fd, std::string& data)
+{
+    char buffer[4096];
+    for (;;) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return false;
+        if (n == 0) return true;
+        data.append(buffer, n);
+    }
+}
+
+// returns false if the path does not fit in sockaddr_un
+static bool socketAddress(const std::filesystem::path& path, sockaddr_un& address)
+{
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.string().size() >= sizeof(address.sun_path)) return false;
+    strcpy(address.sun_path, path.c_str());
+    return true;
+}
+
+static int connectTo(const sockaddr_un& address)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (const sockaddr*)&address, sizeof(address)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// compilation of the request of a client, same as main
+static int compileRequestUnit(const std::string& request, std::ostream& diagnostics, std::string& summary)
+{
+    std::vector<std::string> fields;
+    for (size_t start = 0, end; (end = request.find('\0', start)) != std::string::npos; start = end + 1)
+        fields.push_back(request.substr(start, end - start));
+    if (fields.empty()) {
+        diagnostics << "error: invalid request" << std::endl;
+        return 1;
+    }
+
+    Options options;
+    if (!parseOptions(std::vector<std::string>(fields.begin() + 1, fields.end()), options, diagnostics, fields[0])) return 1;
+    for (const auto& input : options.inputPaths) summary += (summary.empty() ? "" : " ") + input.string();
+    if (options.daemon || options.connect || options.run || options.interp) {
+        diagnostics << "error: --daemon, --connect, --run, --interp and --interp-check cannot be sent to the server" << std::endl;
+        return 1;
+    }
+    if (options.inputPaths.size() > 1) return compileFiles(options, diagnostics);
+    return compileFile(options, diagnostics);
+}
+
+// An exception escaping a request thread would terminate the server and the requests of the other clients:
+// any error of the compiler is the error of its request
+static int compileRequest(const std::string& request, std::ostream& diagnostics, std::string& summary)
+{
+    try {
+        return compileRequestUnit(request, diagnostics, summary);
+    }
+    catch (const std::exception& error) {
+        diagnostics << "error: " << error.what() << std::endl;
+        return 1;
+    }
+}
+
+int runServer(const Options& options)
+{
+    sockaddr_un address;
+    if (!socketAddress(options.socketPath, address)) {
+        std::cerr << "error: the path of the socket is too long: " << options.socketPath.string() << std::endl;
+        return 1;
+    }
+    // a socket file left by a server which did not stop properly is replaced
+    int running = connectTo(address);
+    if (running >= 0) {
+        close(running);
+        std::cerr << "error: a server is already listening on " << options.socketPath.string() << std::endl;
+        return 1;
+    }
+    unlink(address.sun_path);
+
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    mode_t mask = umask(0077);
+    bool bound = server >= 0 && bind(server, (const sockaddr*)&address, sizeof(address)) == 0;
+    umask(mask);
+    if (!bound || listen(server, SOMAXCONN) < 0) {
+        std::cerr << "error: cannot listen on " << options.socketPath.string() << ": " << strerror(errno) << std::endl;
+        if (server >= 0) close(server);
+        return 1;
+    }
+
+    // without SA_RESTART, accept is interrupted by the signals
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stop;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    std::mutex mutex; // protects the log and the number of requests in progress
+    std::condition_variable finished;
+    size_t inProgress = 0;
+    unsigned long requestCount = 0;
+    std::cerr << "ifcc: listening on " << options.socketPath.string() << std::endl;
+
+    while (!stopping) {
+        int client = accept(server, nullptr, nullptr);
+        if (client < 0) continue;
+        auto start = std::chrono::steady_clock::now();
+        unsigned long number;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            number = ++requestCount;
+            ++inProgress;
+        }
+
+        // the signals must interrupt accept, the threads of the requests block them
+        sigset_t signals, previous;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, &previous);
+        std::thread([&, client, start, number]() {
+            std::string request, summary;
+            std::ostringstream diagnostics;
+            int status = 1;
+            if (readAll(client, request)) {
+                status = compileRequest(request, diagnostics, summary);
+                writeAll(client, std::to_string(status) + "\n" + diagnostics.str());
+            }
+            close(client);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            // the connections without request only check that a server is listening (see below)
+            if (!request.empty()) std::cerr << "ifcc: #" << number << " " << (summary.empty() ? "(no input)" : summary) << ": exit status " << status
+                << ", " << std::fixed << std::setprecision(2) << ms << " ms" << std::endl;
+            if (--inProgress == 0) finished.notify_all();
+        }).detach();
+        pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+    }
+
+    close(server);
+    unlink(address.sun_path);
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&]() { return inProgress == 0; });
+    std::cerr << "ifcc: stopped after " << requestCount << " requests" << std::endl;
+    return 0;
+}
+
+int runClient(const Options& options, int argc, char* const* argv)
+{
+    sockaddr_un address;
+    int server = socketAddress(options.socketPath, address) ? connectTo(address) : -1;
+    if (server < 0) {
+        std::cerr << "error: no compile server listening on " << options.socketPath.string() << " (start one with ifcc --daemon)" << std::endl;
+        return 1;
+    }
+
+    std::error_code error;
+    std::string request = std::filesystem::current_path(error).string();
+    request += '\0';
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "--connect" || arg.rfind("--socket=", 0) == 0) continue;
+        request += arg;
+        request += '\0';
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    std::string response;
+    bool ok = writeAll(server, request) && shutdown(server, SHUT_WR) == 0 && readAll(server, response);
+    close(server);
+    size_t newline = response.find('\n');
+    if (!ok || newline == std::string::npos) {
+        std::cerr << "error: the compile server closed the connection" << std::endl;
+        return 1;
+    }
+    std::cerr << response.substr(newline + 1);
+    return atoi(response.substr(0, newline).c_str());
+}
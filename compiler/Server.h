@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Options.h"
+
+/*
+    Compile server (--daemon) and its client (--connect).
+
+    The lexer and the parser of ANTLR keep their ATN and their DFA caches in static members, so a short ifcc
+    process always starts with cold caches. The server is a long-lived process compiling the requests of the
+    clients, each on its own thread: the caches stay warm across the requests and are shared by them.
+    Without a server, the DFA of the parser can be loaded from a snapshot at startup (see DfaSnapshot.h).
+
+    A client sends its working directory and its arguments (without --connect and --socket), the server
+    compiles with the paths resolved against that directory and returns the exit status and the diagnostics,
+    which the client prints before exiting with that status. The server logs the latency of each request.
+
+    The socket is only accessible by the user running the server (mode 0600).
+*/
+
+// Listens on options.socketPath until SIGINT or SIGTERM. Returns the exit status
+int runServer(const Options& options);
+
+// Sends the arguments of the command line to the server listening on options.socketPath. Returns the exit status of the compilation
+int runClient(const Options& options, int argc, char* const* argv);
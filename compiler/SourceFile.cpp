@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "SourceFile.h"
+
+static const size_t READ_CHUNK = 1 << 20;
+
+SourceFile::~SourceFile()
+{
+    if (_mapping) munmap(_mapping, _mappingSize);
+}
+
+bool SourceFile::open(const std::filesystem::path& path)
+{
+    if (path == "-") return read(STDIN_FILENO);
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat status;
+    if (fstat(fd, &status) < 0 || S_ISDIR(status.st_mode)) {
+        close(fd);
+        return false;
+    }
+    // an empty file cannot be mapped, the files which are not regular (pipes, /dev/stdin...) are read
+    if (!S_ISREG(status.st_mode) || status.st_size == 0) {
+        bool ok = read(fd);
+        close(fd);
+        return ok;
+    }
+    void* mapping = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return false;
+    madvise(mapping, status.st_size, MADV_SEQUENTIAL);
+    _mapping = mapping;
+    _mappingSize = status.st_size;
+    _content = std::string_view((const char*)mapping, _mappingSize);
+    return true;
+}
+
+// the chunks are read directly at the end of the buffer, whose capacity doubles
+bool SourceFile::read(int fd)
+{
+    size_t size = 0;
+    for (;;) {
+        if (_buffer.size() - size < READ_CHUNK) _buffer.resize(std::max(2 * _buffer.size(), size + READ_CHUNK));
+        ssize_t n = ::read(fd, &_buffer[size], _buffer.size() - size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return false;
+        if (n == 0) break;
+        size += n;
+    }
+    _buffer.resize(size);
+    _content = _buffer;
+    return true;
+}
+
+void SourceFile::release()
+{
+    if (_mapping) munmap(_mapping, _mappingSize);
+    _mapping = nullptr;
+    _mappingSize = 0;
+    std::string().swap(_buffer);
+    _content = std::string_view();
+}
+
+bool SourceFile::isAscii() const
+{
+    const char* p = _content.data();
+    const char* end = p + _content.size();
+    uint64_t bits = 0;
+    for (; end - p >= 8; p += 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        bits |= word;
+    }
+    for (; p < end; ++p) bits |= (unsigned char)*p;
+    return !(bits & 0x8080808080808080ULL);
+}
+
+void SourceCharStream::consume()
+{
+    if (_p >= _content.size()) throw antlr4::IllegalStateException("cannot consume EOF");
+    ++_p;
+}
+
+size_t SourceCharStream::LA(ssize_t i)
+{
+    if (i == 0) return 0; // undefined
+    if (i < 0) {
+        ++i; // LA(-1) is the previous character
+        if ((ssize_t)_p + i - 1 < 0) return antlr4::IntStream::EOF;
+    }
+    size_t position = _p + i - 1;
+    if (position >= _content.size()) return antlr4::IntStream::EOF;
+    return (unsigned char)_content[position];
+}
+
+std::string SourceCharStream::getText(const antlr4::misc::Interval& interval)
+{
+    if (interval.a < 0 || interval.b < 0 || (size_t)interval.a >= _content.size()) return "";
+    size_t start = interval.a;
+    size_t stop = std::min((size_t)interval.b, _content.size() - 1);
+    if (stop + 1 < start) return "";
+    return std::string(_content.substr(start, stop - start + 1));
+}
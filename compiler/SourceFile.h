@@ -0,0 +1,60 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include "antlr4-runtime.h"
+
+/*
+    Content of the input of a translation unit, read without copy:
+    - a regular file is mapped in memory (mmap), its pages are read by the lexer on demand
+    - the standard input ("-") and the other files (pipes...) are read by chunks at the end of a single buffer,
+      without going through a stream
+    The hand-written lexer and SourceCharStream read the content directly.
+*/
+class SourceFile {
+public:
+    SourceFile() : _mapping(nullptr), _mappingSize(0) {}
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+    ~SourceFile();
+
+    bool open(const std::filesystem::path& path); // false if it cannot be read
+    inline std::string_view content() const { return _content; }
+    bool isAscii() const;
+    void release(); // unmaps or frees the content once it is no longer read (tokens released)
+
+private:
+    bool read(int fd);
+
+    void* _mapping;
+    size_t _mappingSize;
+    std::string _buffer; // content which is not mapped
+    std::string_view _content;
+};
+
+/*
+    CharStream of ifccLexer on the content of a SourceFile made of ASCII characters only: the code points are
+    the bytes, so the stream serves them directly instead of converting the whole content to UTF-32 like
+    ANTLRInputStream. Same behavior as ANTLRInputStream (LA, seek, getText...) for such a content.
+*/
+class SourceCharStream : public antlr4::CharStream {
+public:
+    SourceCharStream(std::string_view content, const std::string& name) : _content(content), _p(0), _name(name) {}
+
+    void consume() override;
+    size_t LA(ssize_t i) override;
+    ssize_t mark() override { return -1; }
+    void release(ssize_t marker) override {}
+    size_t index() override { return _p; }
+    void seek(size_t index) override { _p = std::min(index, _content.size()); }
+    size_t size() override { return _content.size(); }
+    std::string getSourceName() const override { return _name; }
+    std::string getText(const antlr4::misc::Interval& interval) override;
+    std::string toString() const override { return std::string(_content); }
+
+private:
+    std::string_view _content;
+    size_t _p;
+    std::string _name;
+};
@@ -0,0 +1,63 @@
+#include <mutex>
+#include "Symbol.h"
+
+namespace {
+
+thread_local Interner* current = nullptr;
+
+}
+
+Interner::Interner()
+{
+    _names.emplace_back();
+    _symbols.emplace(_names.back(), NO_SYMBOL);
+}
+
+Symbol Interner::intern(std::string_view name)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        auto found = _symbols.find(name);
+        if (found != _symbols.end()) return found->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    auto found = _symbols.find(name); // another thread may have added it in the meantime
+    if (found != _symbols.end()) return found->second;
+    _names.emplace_back(name);
+    Symbol symbol = (Symbol)(_names.size() - 1);
+    _symbols.emplace(_names.back(), symbol);
+    return symbol;
+}
+
+const std::string& Interner::name(Symbol symbol)
+{
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return _names.at(symbol);
+}
+
+InternerScope::InternerScope(Interner& interner) : _previous(current)
+{
+    current = &interner;
+}
+
+InternerScope::~InternerScope()
+{
+    current = _previous;
+}
+
+Interner& currentInterner()
+{
+    if (current) return *current;
+    static Interner process;
+    return process;
+}
+
+Symbol intern(std::string_view name)
+{
+    return currentInterner().intern(name);
+}
+
+const std::string& symbolName(Symbol symbol)
+{
+    return currentInterner().name(symbol);
+}
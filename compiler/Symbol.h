@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/*
+    Identifiers interned in the table of the compilation unit: two names are equal if and only if their symbols
+    are equal, so the symbol tables compare and hash integers instead of strings.
+    Each unit has its own table (see compileFile), installed on its thread by an InternerScope and on the threads
+    of -j N for the duration of each of its tasks: the names are freed with the unit, so a daemon does not keep
+    the names of all its requests, and the units compiled at the same time do not share a lock.
+    The symbols of a unit must not be used by another one.
+*/
+using Symbol = uint32_t;
+
+const Symbol NO_SYMBOL = 0; // the empty name, e.g. of the temporaries of the IR
+
+class Interner {
+public:
+    Interner();
+    Interner(const Interner&) = delete;
+    Interner& operator=(const Interner&) = delete;
+
+    Symbol intern(std::string_view name);
+    const std::string& name(Symbol symbol);
+
+private:
+    std::shared_mutex _mutex; // the tasks of -j N intern the names of their functions concurrently
+    std::deque<std::string> _names; // by symbol, a deque does not move its elements so the keys of _symbols stay valid
+    std::unordered_map<std::string_view, Symbol> _symbols;
+};
+
+// Makes `interner` the table of the current thread until the end of the scope
+class InternerScope {
+public:
+    explicit InternerScope(Interner& interner);
+    ~InternerScope();
+    InternerScope(const InternerScope&) = delete;
+    InternerScope& operator=(const InternerScope&) = delete;
+
+private:
+    Interner* _previous;
+};
+
+// The table of the current thread, a table of the process outside of any InternerScope
+Interner& currentInterner();
+
+Symbol intern(std::string_view name);
+const std::string& symbolName(Symbol symbol);
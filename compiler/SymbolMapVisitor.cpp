@@ -1,5 +1,10 @@
+#include <algorithm>
 #include <iostream>
 #include "SymbolMapVisitor.h"
+#include "CompileError.h"
+#include "ExpressionChain.h"
+
+SymbolMapVisitor::SymbolMapVisitor(std::ostream& diagnostics) : _diagnostics(diagnostics) {}
 
 /*
     - Ensures that all records of variables (used or not) are empty
@@ -9,44 +14,32 @@
 */
 antlrcpp::Any SymbolMapVisitor::visitProg(ifccParser::ProgContext* ctx)
 {
-    _contextSymbolMaps.clear();
-    _contextUnusedSymbols.clear();
+    reset();
+    ifccBaseVisitor::visitProg(ctx);
+    return 0;
+}
+
+void SymbolMapVisitor::reset()
+{
+    _variables.clear();
     _functions.clear();
     _functionParams.clear();
+    _functionCalls.clear();
 
     _functions.insert("putchar");
     _functionParams["putchar"] = 1;
     _functions.insert("getchar");
     _functionParams["getchar"] = 0;
-
-    ifccBaseVisitor::visitProg(ctx);
-    return 0;
 }
 
 
 antlrcpp::Any SymbolMapVisitor::visitFunction_def(ifccParser::Function_defContext* ctx)
 {
-    pushContext();
-    std::string funcName(ctx->IDENTIFIER()[0]->getText());
-    if (_functions.find(funcName) != _functions.end()) {
-        std::cerr << "error: Function " << funcName << " already defined." << std::endl;
-        exit(1);
-    }
-    _functions.insert(funcName);
-
-    // Liste des types
-    auto types = ctx->TYPE();
     // Liste des identifiants (paramètres)
     auto preIdentifiers = ctx->IDENTIFIER();
-    auto identifiers = std::vector<antlr4::tree::TerminalNode *>(preIdentifiers.begin() + 1, preIdentifiers.end());
-
-    if (!types.empty() && !identifiers.empty()) {
-        _functionParams[funcName] = identifiers.size();
-        for (int i = 0; i < identifiers.size(); ++i)
-            addVariable(identifiers[i]->getText());
-    }
-    else
-        _functionParams[funcName] = 0;
+    std::vector<Symbol> params;
+    for (size_t i = 1; i < preIdentifiers.size(); ++i) params.push_back(intern(preIdentifiers[i]->getText()));
+    beginFunction(preIdentifiers[0]->getText(), params);
 
     // Visiter le corps de la fonction
     for (auto stmt : ctx->stmt()) {
@@ -56,24 +49,65 @@ antlrcpp::Any SymbolMapVisitor::visitFunction_def(ifccParser::Function_defContex
     return 0;
 }
 
+void SymbolMapVisitor::beginFunction(const std::string& funcName, const std::vector<Symbol>& params)
+{
+    pushContext();
+    if (_functions.find(funcName) != _functions.end()) {
+        throw CompileError("Function " + funcName + " already defined.");
+    }
+    _functions.insert(funcName);
+    _functionCalls[funcName];
+    _currentFunction = funcName;
+
+    _functionParams[funcName] = params.size();
+    for (const auto& param : params) addVariable(param);
+}
+
 antlrcpp::Any SymbolMapVisitor::visitExpr_fct_call(ifccParser::Expr_fct_callContext* ctx)
 {
-    std::string funcName(ctx->IDENTIFIER()->getText());
+    checkCall(ctx->IDENTIFIER()->getText(), ctx->expression().size());
+
+    // the arguments can use variables and call other functions
+    visitChildren(ctx);
+    return 0;
+}
+
+void SymbolMapVisitor::checkCall(const std::string& funcName, size_t argCount)
+{
     if (_functions.find(funcName) == _functions.end()) {
-        std::cerr << "error: Function " << funcName << " not defined." << std::endl;
-        exit(1);
+        throw CompileError("Function " + funcName + " not defined.");
     }
-    auto expre = ctx->expression();
-    int nbParam;
-    if (!expre.empty())
-        nbParam = expre.size();
-    else
-        nbParam = 0;
-    if (nbParam != _functionParams[funcName]) {
-        std::cerr << "error: Function call " << funcName << " with not enough parameters." << std::endl;
-        exit(1);
+    if ((int)argCount != _functionParams[funcName]) {
+        throw CompileError("Function call " + funcName + " with not enough parameters.");
     }
-    return 0;
+    _functionCalls[_currentFunction].insert(funcName);
+}
+
+/*
+    A function is pure if it does not call putchar or getchar, directly or through the functions it calls.
+    The language has no global variables nor pointers: such a function always returns the same value
+    for the same arguments, so its calls with constant arguments can be evaluated at compile time.
+*/
+std::set<std::string> SymbolMapVisitor::getPureFunctions() const
+{
+    std::set<std::string> pure;
+    for (const auto& function : _functionCalls) pure.insert(function.first);
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const auto& function : _functionCalls) {
+            if (pure.find(function.first) == pure.end()) continue;
+            for (const auto& callee : function.second) {
+                if (pure.find(callee) == pure.end()) {
+                    pure.erase(function.first);
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+    return pure;
 }
 
 antlrcpp::Any SymbolMapVisitor::visitStmt_block(ifccParser::Stmt_blockContext* ctx)
@@ -92,8 +126,7 @@ antlrcpp::Any SymbolMapVisitor::visitStmt_block(ifccParser::Stmt_blockContext* c
 */
 antlrcpp::Any SymbolMapVisitor::visitDeclaration(ifccParser::DeclarationContext* ctx)
 {
-    std::string varname = ctx->IDENTIFIER()->getText();
-    addVariable(varname);
+    addVariable(intern(ctx->IDENTIFIER()->getText()));
     visitChildren(ctx);
     return 0;
 }
@@ -105,56 +138,63 @@ antlrcpp::Any SymbolMapVisitor::visitDeclaration(ifccParser::DeclarationContext*
 */
 antlrcpp::Any SymbolMapVisitor::visitExpr_ident(ifccParser::Expr_identContext* ctx)
 {
-    std::string varname = ctx->IDENTIFIER()->getText();
-    useVariable(varname);
+    useVariable(intern(ctx->IDENTIFIER()->getText()));
     return 0;
 }
 
 
+/*
+    The binary operators have no check of their own: the first operand of the chain is visited,
+    then the right operands from the innermost operator, in the order of the recursive visit
+*/
+antlrcpp::Any SymbolMapVisitor::visitChildren(antlr4::tree::ParseTree* node)
+{
+    if (!isBinaryExpression(node)) return ifccBaseVisitor::visitChildren(node);
+    size_t base = _chain.size();
+    visit(leftChain(dynamic_cast<ifccParser::ExpressionContext*>(node), _chain));
+    while (_chain.size() > base) {
+        ifccParser::ExpressionContext* binary = _chain.back();
+        _chain.pop_back();
+        visit(rightOperand(binary));
+    }
+    return 0;
+}
 
 void SymbolMapVisitor::pushContext()
 {
-    _contextSymbolMaps.push_back(std::set<std::string>());
-    _contextUnusedSymbols.push_back(std::set<std::string>());
+    _variables.pushScope();
 }
 
+// the unused variables are listed in alphabetical order
 void SymbolMapVisitor::popContext()
 {
-    const auto& unused = _contextUnusedSymbols[_contextUnusedSymbols.size() - 1];
+    std::vector<std::string> unused;
+    for (auto it = _variables.scopeBegin(); it != _variables.scopeEnd(); ++it)
+        if (!it->value) unused.push_back(symbolName(it->symbol));
     if (!unused.empty()) {
-        std::cerr << "error: Unused variable detected : ";
-        for (const auto& symbol : unused) std::cerr << symbol << " ";
-        std::cerr << std::endl;
+        std::sort(unused.begin(), unused.end());
+        _diagnostics << "error: Unused variable detected : ";
+        for (const auto& symbol : unused) _diagnostics << symbol << " ";
+        _diagnostics << std::endl;
     }
-    _contextSymbolMaps.pop_back();
-    _contextUnusedSymbols.pop_back();
+    _variables.popScope();
 }
 
 /*
-    - Computes the address where the variable should be stored thanks to the information about the variable size
-    - Creates a new line in the symbol table, associating the variable name to a memory address
-    - Adds the freshly-created variable to the list of unused table
+    - Declares the variable in the current context, where it must not be already declared
+    - The variable is unused until useVariable finds it
 */
-void SymbolMapVisitor::addVariable(std::string name)
+void SymbolMapVisitor::addVariable(Symbol name)
 {
-    auto& currentMap = _contextSymbolMaps[_contextSymbolMaps.size() - 1];
-    if (!currentMap.empty() && currentMap.find(name) != currentMap.end()) {
-        std::cerr << "error: Variable already defined." << std::endl;
-        exit(1);
+    if (!_variables.declare(name, false)) {
+        throw CompileError("Variable already defined.");
     }
-    currentMap.insert(name);
-    _contextUnusedSymbols[_contextUnusedSymbols.size() - 1].insert(name);
 }
 
-void SymbolMapVisitor::useVariable(std::string name)
+// marks the innermost variable with this name as used
+void SymbolMapVisitor::useVariable(Symbol name)
 {
-    for (int i = _contextSymbolMaps.size() - 1; i >= 0; i--) {
-        const auto& symbolMap = _contextSymbolMaps[i];
-        auto& unused = _contextUnusedSymbols.at(i);
-        if (symbolMap.empty() || symbolMap.find(name) == symbolMap.end()) continue;
-        unused.erase(name);
-        return;
-    }
-    std::cerr << "error: Undefined variable." << std::endl;
-    exit(1);
+    bool* used = _variables.lookup(name);
+    if (!used) throw CompileError("Undefined variable.");
+    *used = true;
 }
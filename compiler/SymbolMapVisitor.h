@@ -3,12 +3,17 @@
 #include <string>
 #include <map>
 #include <set>
+#include <iostream>
 #include "antlr4-runtime.h"
 #include "generated/ifccBaseVisitor.h"
+#include "ScopedSymbolTable.h"
 
 
+// The errors which stop the compilation are thrown as CompileError, the others are written on the diagnostics
 class SymbolMapVisitor : public ifccBaseVisitor {
 public:
+    SymbolMapVisitor(std::ostream& diagnostics = std::cerr);
+
     // This method only parses the grammar elements which lead to a modification of the symbol map and/or the used symbol map
     virtual antlrcpp::Any visitProg(ifccParser::ProgContext* ctx) override;
 
@@ -23,15 +28,28 @@ public:
     // This method updates the usage of status of variable
     virtual antlrcpp::Any visitExpr_ident(ifccParser::Expr_identContext* ctx) override;
 
+    // The operands of the binary operators are visited without recursing on the left ones (see ExpressionChain.h)
+    virtual antlrcpp::Any visitChildren(antlr4::tree::ParseTree* node) override;
+
+    // Checks shared with the hand-written parser path (ast/SymbolCheck.h)
+    void reset();
+    void beginFunction(const std::string& name, const std::vector<Symbol>& params); // pushes the context of the function
+    void checkCall(const std::string& name, size_t argCount);
+
     void pushContext();
     void popContext();
-    void addVariable(std::string name);
-    void useVariable(std::string name);
+    void addVariable(Symbol name);
+    void useVariable(Symbol name);
     inline std::set<std::string>& getFunctionSet() { return _functions; }
+    std::set<std::string> getPureFunctions() const; // functions without I/O, even through their calls
+
 private:
-    std::vector<std::set<std::string>> _contextSymbolMaps; // The symbol table associates a block name and a variable names to their location in the allocated memory.
-    std::vector<std::set<std::string>> _contextUnusedSymbols;
+    ScopedSymbolTable<bool> _variables; // The variables of the open contexts, and whether they are used
     
     std::set<std::string> _functions; // Set with all the names of all functions
     std::map<std::string, int> _functionParams; // A map indicating the number of parameters a function has
+    std::map<std::string, std::set<std::string>> _functionCalls; // The functions called by each function
+    std::string _currentFunction;
+    std::vector<ifccParser::ExpressionContext*> _chain; // work stack of visitChildren
+    std::ostream& _diagnostics;
 };
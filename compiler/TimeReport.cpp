@@ -0,0 +1,44 @@
+#include <iomanip>
+#include "TimeReport.h"
+
+TimeReport::TimeReport(bool enabled, std::ostream& output) : _enabled(enabled), _output(output), _running(false), _inputSize(0) {}
+
+TimeReport::~TimeReport()
+{
+    if (_enabled) print(_output);
+}
+
+void TimeReport::phase(const std::string& name, bool throughput)
+{
+    if (!_enabled) return;
+    endPhase();
+    _phases.push_back({ name, throughput, 0, 0 });
+    _running = true;
+    _start = std::chrono::steady_clock::now();
+}
+
+void TimeReport::endPhase()
+{
+    if (!_running) return;
+    _phases.back().seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+    _running = false;
+}
+
+void TimeReport::print(std::ostream& o)
+{
+    endPhase();
+    double total = 0;
+    o << "Time report (" << _inputSize << " bytes):" << std::endl;
+    for (const auto& phase : _phases) {
+        o << "  " << std::left << std::setw(20) << phase.name << std::right << std::fixed << std::setprecision(3)
+            << std::setw(10) << phase.seconds * 1000 << " ms";
+        if (phase.throughput && phase.seconds > 0)
+            o << std::setw(12) << std::setprecision(1) << _inputSize / phase.seconds / 1e6 << " MB/s";
+        else if (phase.outputSize && phase.seconds > 0)
+            o << std::setw(12) << std::setprecision(1) << phase.outputSize / phase.seconds / 1e6 << " MB/s of output";
+        o << std::endl;
+        total += phase.seconds;
+    }
+    o << "  " << std::left << std::setw(20) << "total" << std::right << std::setprecision(3) << std::setw(10) << total * 1000 << " ms" << std::endl;
+    _phases.clear();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <iostream>
+
+// Time spent in each phase of the compilation (-ftime-report), printed on `output` when the report is destroyed
+class TimeReport {
+public:
+    TimeReport(bool enabled, std::ostream& output = std::cerr);
+    ~TimeReport();
+
+    // Ends the current phase and starts a new one. The throughput of the phases over the input is given in MB/s
+    void phase(const std::string& name, bool throughput = false);
+    inline void setInputSize(size_t bytes) { _inputSize = bytes; }
+    // size of the output of the current phase, its throughput is given in MB/s of output
+    inline void setOutputSize(size_t bytes) { if (!_phases.empty()) _phases.back().outputSize = bytes; }
+
+    void print(std::ostream& o);
+
+private:
+    struct Phase {
+        std::string name;
+        bool throughput;
+        double seconds;
+        size_t outputSize;
+    };
+
+    void endPhase();
+
+    bool _enabled;
+    std::ostream& _output;
+    std::vector<Phase> _phases;
+    bool _running;
+    std::chrono::steady_clock::time_point _start;
+    size_t _inputSize;
+};
@@ -0,0 +1,102 @@
+#include "WorkStealingPool.h"
+
+WorkStealingPool::WorkStealingPool(unsigned threads) : _task(nullptr), _remaining(0), _generation(0), _stopping(false), _errorIndex(0)
+{
+    if (threads == 0) threads = 1;
+    for (unsigned i = 0; i < threads; ++i) _queues.push_back(std::make_unique<Queue>());
+    for (unsigned i = 1; i < threads; ++i) _workers.emplace_back(&WorkStealingPool::worker, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wake.notify_all();
+    for (auto& thread : _workers) thread.join();
+}
+
+void WorkStealingPool::run(size_t count, const std::function<void(size_t, unsigned)>& task)
+{
+    if (count == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _task = &task;
+        _remaining = count;
+        _error = nullptr;
+        size_t threads = _queues.size();
+        for (size_t i = 0; i < threads; ++i) {
+            std::lock_guard<std::mutex> queueLock(_queues[i]->mutex);
+            for (size_t index = count * i / threads; index < count * (i + 1) / threads; ++index)
+                _queues[i]->tasks.push_back(index);
+        }
+        ++_generation;
+    }
+    _wake.notify_all();
+
+    work(0);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this]() { return _remaining == 0; });
+    if (_error) std::rethrow_exception(_error);
+}
+
+// the next task of the deque of `thread`, or one stolen from another deque
+bool WorkStealingPool::take(unsigned thread, size_t& index)
+{
+    {
+        Queue& own = *_queues[thread];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            index = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < _queues.size(); ++i) {
+        Queue& victim = *_queues[(thread + i) % _queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            index = victim.tasks.back();
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::work(unsigned thread)
+{
+    size_t index;
+    while (take(thread, index)) {
+        try {
+            (*_task)(index, thread);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_error || index < _errorIndex) {
+                _error = std::current_exception();
+                _errorIndex = index;
+            }
+        }
+        if (--_remaining == 0) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _done.notify_all();
+        }
+    }
+}
+
+void WorkStealingPool::worker(unsigned thread)
+{
+    unsigned long generation = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [&]() { return _stopping || _generation != generation; });
+            if (_stopping) return;
+            generation = _generation;
+        }
+        work(thread);
+    }
+}
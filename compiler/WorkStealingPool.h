@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+    Pool of threads running the tasks 0 to count - 1 of run(), used to compile the functions of a translation unit
+    in parallel (-j N). The calling thread is thread 0 and takes part in the work.
+
+    Each thread has its own deque, filled with a contiguous range of the tasks: a thread takes its tasks from the
+    front, and when its deque is empty it steals from the back of the others, so a few large functions do not
+    leave the other threads idle.
+*/
+class WorkStealingPool {
+public:
+    WorkStealingPool(unsigned threads);
+    ~WorkStealingPool();
+
+    inline unsigned getThreadCount() const { return _queues.size(); }
+
+    // Runs task(index, thread) for every index of [0, count) and returns when they are all done.
+    // If tasks throw, the exception of the first of them (by index) is rethrown once they are all done.
+    void run(size_t count, const std::function<void(size_t, unsigned)>& task);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    bool take(unsigned thread, size_t& index);
+    void work(unsigned thread);
+    void worker(unsigned thread);
+
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _workers;
+    const std::function<void(size_t, unsigned)>* _task;
+    std::atomic<size_t> _remaining;
+
+    std::mutex _mutex; // protects the fields below
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    unsigned long _generation; // number of calls of run(), the workers wait for the next one
+    bool _stopping;
+    std::exception_ptr _error;
+    size_t _errorIndex;
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+#include "../Symbol.h"
+#include "../ir/Arena.h"
+
+/*
+    Compact AST of the grammar ifcc.g4, built by the hand-written parser (--parser=hand).
+    The parentheses do not produce nodes, the operators are stored as enums instead of tokens.
+    The nodes and their lists are allocated one after the other in the arena of the Program, they have no
+    destructor and are all released with the program.
+*/
+namespace ast {
+
+// Array of nodes in the arena of the program
+template <typename T>
+struct List {
+    T* items = nullptr;
+    uint32_t count = 0;
+
+    inline T* begin() const { return items; }
+    inline T* end() const { return items + count; }
+    inline size_t size() const { return count; }
+    inline bool empty() const { return count == 0; }
+    inline T& operator[](size_t i) const { return items[i]; }
+};
+
+enum class ExprKind : uint8_t {
+    Const,      // value
+    Ident,      // name
+    Call,       // name(operands...)
+    Negate,     // -operands[0]
+    Plus,       // +operands[0]
+    Not,        // !operands[0]
+    Binary,     // operands[0] op operands[1]
+    Assign,     // name = operands[0]
+    AddAssign,  // name += operands[0]
+    SubAssign,  // name -= operands[0]
+    PreIncr,    // ++name
+    PreDecr,    // --name
+    PostIncr,   // name++
+    PostDecr,   // name--
+};
+
+enum class BinaryOp : uint8_t { Mul, Div, Mod, Add, Sub, BitAnd, BitXor, BitOr, Lt, Gt, Le, Ge, Eq, Ne, LazyAnd, LazyOr };
+
+struct Expr {
+    Expr(ExprKind kind) : kind(kind), op(BinaryOp::Add), name(NO_SYMBOL), value(0) {}
+
+    ExprKind kind;
+    BinaryOp op;
+    Symbol name; // of the variable or of the called function
+    int value;
+    List<Expr*> operands;
+};
+
+enum class StmtKind : uint8_t {
+    Declaration, // TYPE declarators
+    Expression,  // expr; (expr can be null)
+    Return,      // return expr; (expr can be null)
+    Block,       // { body }
+    If,          // if (expr) body[0] else body[1] (body[1] is optional)
+    While,       // while (expr) body[0], body[0] is a Block
+};
+
+struct Declarator {
+    Symbol name;
+    Expr* init; // can be null
+};
+
+struct Stmt {
+    Stmt(StmtKind kind) : kind(kind), expr(nullptr) {}
+
+    StmtKind kind;
+    Expr* expr;
+    List<Declarator> declarators;
+    List<Stmt*> body;
+};
+
+struct Function {
+    std::string name;
+    bool returnsVoid = false;
+    std::vector<Symbol> params;
+    List<Stmt*> body;
+    size_t firstToken = 0, lastToken = 0; // indices of the definition in the token stream (see FunctionCache)
+};
+
+struct Program {
+    std::vector<Function> functions;
+    IR::Arena arena;
+
+    inline Expr* expr(ExprKind kind) { return arena.create<Expr>(kind); }
+    inline Stmt* stmt(StmtKind kind) { return arena.create<Stmt>(kind); }
+    template <typename T>
+    List<T> list(const T* items, size_t count) { return List<T>{ arena.copyArray(items, count), (uint32_t)count }; }
+    template <typename T>
+    inline List<T> list(const std::vector<T>& items) { return list(items.data(), items.size()); }
+    template <typename T>
+    inline List<T> list(std::initializer_list<T> items) { return list(items.begin(), items.size()); }
+};
+
+}
@@ -0,0 +1,336 @@
+#include "CFGBuilder.h"
+#include "../ir/Instruction.h"
+#include "../CompileError.h"
+
+using namespace ast;
+
+CFGBuilder::CFGBuilder(IR::ControlFlowGraph& cfg, SymbolMapVisitor* symbols) : _cfg(cfg), _symbols(symbols), _returnBlock(nullptr) {}
+
+void CFGBuilder::build(const Program& program)
+{
+    if (_symbols) _symbols->reset();
+    for (const auto& f : program.functions) function(f);
+    if (_deferredError) std::rethrow_exception(_deferredError);
+}
+
+const IR::Variable& CFGBuilder::targetVar(Symbol name)
+{
+    try {
+        return _cfg.getSymbolVar(name);
+    }
+    catch (const CompileError&) {
+        if (!_symbols) throw;
+        if (!_deferredError) _deferredError = std::current_exception();
+        return _cfg.createTmpVar();
+    }
+}
+
+// same blocks as CFGVisitor::visitFunction_def
+void CFGBuilder::function(const Function& function)
+{
+    const std::string& name = function.name;
+    if (_symbols) _symbols->beginFunction(name, function.params);
+    _cfg.pushContext();
+
+    IR::GenFunc* genFuncI;
+    if (!name.compare("main")) {
+        _cfg.createAndAddBlock(name);
+        genFuncI = &_cfg.getCurrentBlock().addInstruction<IR::GenFunc>(name);
+    }
+    else {
+        std::vector<IR::Variable> varList;
+        size_t i;
+        for (i = 0; i < function.params.size() && i < 6; ++i)
+            varList.push_back(_cfg.createSymbolVar(function.params[i]));
+        int addressPos = 8;
+        for (; i < function.params.size(); ++i) {
+            addressPos += 8;
+            varList.push_back(_cfg.createSymbolVar(function.params[i], addressPos));
+        }
+        std::string signature = name + "(";
+        if (!varList.empty())
+            signature += "int";
+        for (size_t j = 1; j < varList.size(); ++j)
+            signature += ", int";
+        signature += ")";
+
+        _cfg.createAndAddBlock(signature);
+        genFuncI = &_cfg.getCurrentBlock().addInstruction<IR::GenFunc>(name, varList);
+    }
+    if (_cfg.getOptions().profile) _cfg.getCurrentBlock().addInstruction<IR::ProfileEnter>(name);
+
+    IR::BasicBlock* retBlock = _cfg.createBlock();
+    _returnBlock = retBlock;
+    if (_cfg.getOptions().profile) retBlock->addInstruction<IR::ProfileExit>(name);
+    retBlock->addInstruction<IR::Return>();
+
+    for (const auto& s : function.body) stmt(*s);
+
+    // main returns 0 when the execution reaches its end
+    if (!name.compare("main")) _cfg.getCurrentBlock().addInstruction<IR::LdConst>(0);
+
+    _cfg.addBlock(retBlock);
+    _cfg.popContext();
+    if (_symbols) _symbols->popContext();
+    _returnBlock = nullptr;
+    genFuncI->stackSize = _cfg.resetMemoryCount();
+}
+
+/*
+    The nested statements are walked with a work stack, so the nesting of the blocks is not limited by the native
+    stack. A frame is visited once before each of its sub-statements and once after the last one: the code of a
+    statement between its sub-statements is the one of the recursive walk of CFGVisitor, in the same order.
+*/
+void CFGBuilder::stmt(const Stmt& root)
+{
+    _stmts.assign(1, { &root, 0, nullptr, nullptr });
+    while (!_stmts.empty()) {
+        // the frame is copied, pushing a sub-statement can move the stack
+        StmtFrame frame = _stmts.back();
+        const Stmt& stmt = *frame.stmt;
+        size_t next = _stmts.back().next++;
+        const Stmt* sub = nullptr;
+
+        switch (stmt.kind) {
+        case StmtKind::Declaration:
+            for (const auto& declarator : stmt.declarators) {
+                if (_symbols) _symbols->addVariable(declarator.name);
+                const auto& variable = _cfg.createSymbolVar(declarator.name);
+                if (declarator.init) {
+                    expr(*declarator.init);
+                    _cfg.getCurrentBlock().addInstruction<IR::Store>(variable);
+                }
+            }
+            break;
+
+        case StmtKind::Expression:
+            if (stmt.expr) expr(*stmt.expr);
+            break;
+
+        case StmtKind::Return:
+            if (stmt.expr) expr(*stmt.expr);
+            _cfg.getCurrentBlock().setExit(*_returnBlock);
+            _cfg.createAndAddBlock();
+            break;
+
+        case StmtKind::Block:
+            if (next == 0) {
+                if (_symbols) _symbols->pushContext();
+                _cfg.pushContext();
+            }
+            if (next < stmt.body.size()) sub = stmt.body[next];
+            else {
+                _cfg.popContext();
+                if (_symbols) _symbols->popContext();
+            }
+            break;
+
+        case StmtKind::If:
+            if (next == 0) {
+                IR::BasicBlock& blockCurr = _cfg.getCurrentBlock();
+                expr(*stmt.expr);
+
+                IR::BasicBlock& blockThen = _cfg.createAndAddBlock();
+                blockCurr.setExitTrue(blockThen);
+                _stmts.back().first = &blockCurr;
+                sub = stmt.body[0];
+                break;
+            }
+            if (next == 1) {
+                _stmts.back().thenEnd = &_cfg.getCurrentBlock();
+
+                IR::BasicBlock& blockElse = _cfg.createAndAddBlock();
+                frame.first->setExitFalse(blockElse);
+                if (stmt.body.size() > 1) {
+                    sub = stmt.body[1];
+                    break;
+                }
+            }
+            {
+                IR::BasicBlock& blockElseEnd = _cfg.getCurrentBlock();
+                IR::BasicBlock& blockEndIf = _cfg.createAndAddBlock();
+                _stmts.back().thenEnd->setExit(blockEndIf);
+                blockElseEnd.setExit(blockEndIf);
+            }
+            break;
+
+        case StmtKind::While:
+            if (next == 0) {
+                IR::BasicBlock& blockConditionWhile = _cfg.createAndAddBlock();
+                expr(*stmt.expr);
+
+                IR::BasicBlock& blockBody = _cfg.createAndAddBlock();
+                blockConditionWhile.setExitTrue(blockBody);
+                _stmts.back().first = &blockConditionWhile;
+                sub = stmt.body[0];
+            }
+            else {
+                IR::BasicBlock& blockBodyEnd = _cfg.getCurrentBlock();
+                blockBodyEnd.setExit(*frame.first);
+
+                IR::BasicBlock& blockEndWhile = _cfg.createAndAddBlock();
+                frame.first->setExitFalse(blockEndWhile);
+            }
+            break;
+        }
+
+        if (sub) _stmts.push_back({ sub, 0, nullptr, nullptr });
+        else _stmts.pop_back();
+    }
+}
+
+void CFGBuilder::expr(const Expr& expr)
+{
+    IR::BasicBlock& block = _cfg.getCurrentBlock();
+    switch (expr.kind) {
+    case ExprKind::Const:
+        block.addInstruction<IR::LdConst>(expr.value);
+        break;
+
+    case ExprKind::Ident:
+        if (_symbols) _symbols->useVariable(expr.name);
+        block.addInstruction<IR::LdLoc>(_cfg.getSymbolVar(expr.name));
+        break;
+
+    case ExprKind::Call: {
+        if (_symbols) _symbols->checkCall(symbolName(expr.name), expr.operands.size());
+        std::vector<std::string> registre = { "%edi", "%esi", "%edx", "%ecx", "%r8d", "%r9d" };
+        std::vector<IR::Variable> varVector;
+        for (const auto& arg : expr.operands) varVector.push_back(exprAndStore(*arg));
+        if (!varVector.empty()) {
+            for (size_t i = 1; i < varVector.size() && i < 6; ++i)
+                _cfg.getCurrentBlock().addInstruction<IR::MovToReg>(varVector[i], registre[i]);
+            for (size_t i = varVector.size() - 1; i > 5; --i) {
+                _cfg.getCurrentBlock().addInstruction<IR::MovToReg>(varVector[i], "%edi");
+                _cfg.getCurrentBlock().addInstruction<IR::PushQ>();
+            }
+            _cfg.getCurrentBlock().addInstruction<IR::MovToReg>(varVector[0], registre[0]);
+        }
+        _cfg.getCurrentBlock().addInstruction<IR::CallFunc>(symbolName(expr.name), varVector);
+        break;
+    }
+
+    case ExprKind::Negate:
+        this->expr(*expr.operands[0]);
+        _cfg.getCurrentBlock().addInstruction<IR::Negate>();
+        break;
+
+    case ExprKind::Plus:
+        this->expr(*expr.operands[0]);
+        break;
+
+    case ExprKind::Not:
+        this->expr(*expr.operands[0]);
+        _cfg.getCurrentBlock().addInstruction<IR::LogicalNot>();
+        break;
+
+    case ExprKind::Binary: {
+        // the left operands of a chain are walked in a loop (see ExpressionChain.h), then the operators are
+        // completed from the innermost one
+        size_t base = _chain.size();
+        const Expr* first = &expr;
+        for (; first->kind == ExprKind::Binary; first = first->operands[0]) _chain.push_back(first);
+        this->expr(*first);
+        while (_chain.size() > base) {
+            const Expr* binary = _chain.back();
+            _chain.pop_back();
+            completeBinary(*binary);
+        }
+        break;
+    }
+
+    case ExprKind::Assign: {
+        const auto& variable = targetVar(expr.name);
+        this->expr(*expr.operands[0]);
+        _cfg.getCurrentBlock().addInstruction<IR::Store>(variable);
+        break;
+    }
+
+    case ExprKind::AddAssign:
+    case ExprKind::SubAssign: {
+        const auto& variable = targetVar(expr.name);
+        this->expr(*expr.operands[0]);
+        if (expr.kind == ExprKind::AddAssign) _cfg.getCurrentBlock().addInstruction<IR::Add>(variable);
+        else _cfg.getCurrentBlock().addInstruction<IR::Sub>(variable);
+        _cfg.getCurrentBlock().addInstruction<IR::Store>(variable);
+        break;
+    }
+
+    case ExprKind::PreIncr:
+    case ExprKind::PreDecr: {
+        const auto& variable = targetVar(expr.name);
+        block.addInstruction<IR::LdConst>(1);
+        if (expr.kind == ExprKind::PreIncr) block.addInstruction<IR::Add>(variable);
+        else block.addInstruction<IR::Sub>(variable);
+        block.addInstruction<IR::Store>(variable);
+        break;
+    }
+
+    case ExprKind::PostIncr:
+    case ExprKind::PostDecr: {
+        // the previous value is kept in a temporary variable and loaded at the end
+        const auto& variable = targetVar(expr.name);
+        const auto& variableTmp = _cfg.createTmpVar();
+        block.addInstruction<IR::LdLoc>(variable);
+        block.addInstruction<IR::Store>(variableTmp);
+        block.addInstruction<IR::LdConst>(1);
+        if (expr.kind == ExprKind::PostIncr) block.addInstruction<IR::Add>(variable);
+        else block.addInstruction<IR::Sub>(variable);
+        block.addInstruction<IR::Store>(variable);
+        block.addInstruction<IR::LdLoc>(variableTmp);
+        break;
+    }
+    }
+}
+
+// the operator of a binary expression whose left operand has just been generated (its value is in the register)
+void CFGBuilder::completeBinary(const Expr& expr)
+{
+    if (expr.op == BinaryOp::LazyAnd || expr.op == BinaryOp::LazyOr) {
+        // same blocks as CFGVisitor::completeLazy
+        _cfg.getCurrentBlock().addInstruction<IR::CastBool>();
+        IR::BasicBlock& leftBlock = _cfg.getCurrentBlock();
+        IR::BasicBlock& rightBlock = _cfg.createAndAddBlock();
+        if (expr.op == BinaryOp::LazyAnd) leftBlock.setExitTrue(rightBlock);
+        else leftBlock.setExitFalse(rightBlock);
+
+        this->expr(*expr.operands[1]);
+        _cfg.getCurrentBlock().addInstruction<IR::CastBool>();
+        IR::BasicBlock& afterBlock = _cfg.createAndAddBlock();
+        if (expr.op == BinaryOp::LazyAnd) leftBlock.setExitFalse(afterBlock);
+        else leftBlock.setExitTrue(afterBlock);
+        rightBlock.setExit(afterBlock);
+        return;
+    }
+
+    // the left operand is stored as in exprAndStore
+    const IR::Variable& lhs = _cfg.createTmpVar();
+    _cfg.getCurrentBlock().addInstruction<IR::Store>(lhs);
+    this->expr(*expr.operands[1]);
+    IR::BasicBlock& current = _cfg.getCurrentBlock();
+    switch (expr.op) {
+    case BinaryOp::Mul: current.addInstruction<IR::Mul>(lhs); break;
+    case BinaryOp::Div: current.addInstruction<IR::Div>(lhs); break;
+    case BinaryOp::Mod: current.addInstruction<IR::Mod>(lhs); break;
+    case BinaryOp::Add: current.addInstruction<IR::Add>(lhs); break;
+    case BinaryOp::Sub: current.addInstruction<IR::Sub>(lhs); break;
+    case BinaryOp::BitAnd: current.addInstruction<IR::BitAnd>(lhs); break;
+    case BinaryOp::BitXor: current.addInstruction<IR::BitXor>(lhs); break;
+    case BinaryOp::BitOr: current.addInstruction<IR::BitOr>(lhs); break;
+    case BinaryOp::Lt: current.addInstruction<IR::CompLt>(lhs); break;
+    case BinaryOp::Gt: current.addInstruction<IR::CompGt>(lhs); break;
+    case BinaryOp::Le: current.addInstruction<IR::CompLtEq>(lhs); break;
+    case BinaryOp::Ge: current.addInstruction<IR::CompGtEq>(lhs); break;
+    case BinaryOp::Eq: current.addInstruction<IR::CompEq>(lhs); break;
+    case BinaryOp::Ne: current.addInstruction<IR::CompNe>(lhs); break;
+    default: break;
+    }
+}
+
+const IR::Variable& CFGBuilder::exprAndStore(const Expr& expr)
+{
+    this->expr(expr);
+    const IR::Variable& lhs = _cfg.createTmpVar();
+    _cfg.getCurrentBlock().addInstruction<IR::Store>(lhs);
+    return lhs;
+}
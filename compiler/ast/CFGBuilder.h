@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Ast.h"
+#include "../ir/ControlFlowGraph.h"
+#include "../SymbolMapVisitor.h"
+
+namespace ast {
+
+/*
+    Generates the IR of the AST of the hand-written parser.
+    It must generate exactly the same instructions and blocks as CFGVisitor does from the ANTLR tree.
+    With --sema=fused, it also makes the checks of SymbolCheck in the same order, like CFGVisitor.
+*/
+class CFGBuilder {
+public:
+    CFGBuilder(IR::ControlFlowGraph& cfg, SymbolMapVisitor* symbols = nullptr);
+
+    void build(const Program& program);
+    void function(const Function& function); // a single function, in its own graph with -j N
+
+protected:
+    // statement being walked, with the number of its sub-statements already started
+    struct StmtFrame {
+        const Stmt* stmt;
+        size_t next;
+        IR::BasicBlock* first; // block of the condition of an if (before it) or of a while
+        IR::BasicBlock* thenEnd; // last block of the then branch of an if
+    };
+
+    void stmt(const Stmt& stmt);
+    void expr(const Expr& expr);
+    void completeBinary(const Expr& expr);
+    const IR::Variable& exprAndStore(const Expr& expr);
+    const IR::Variable& targetVar(Symbol name); // see CFGVisitor::targetVar
+
+    IR::ControlFlowGraph& _cfg;
+    SymbolMapVisitor* _symbols;
+    std::exception_ptr _deferredError;
+    IR::BasicBlock* _returnBlock;
+    std::vector<const Expr*> _chain; // work stack of the chains of binary operators
+    std::vector<StmtFrame> _stmts; // work stack of the nested statements
+};
+
+}
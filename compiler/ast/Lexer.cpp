@@ -0,0 +1,358 @@
+#include <algorithm>
+#include <iostream>
+#include "Lexer.h"
+#include "../CompileError.h"
+#include "generated/ifccLexer.h"
+#ifdef __SSE2__
+#include <immintrin.h>
+#endif
+
+using namespace ast;
+
+// ---------------------------------------------------------------- character classes
+
+enum : unsigned char {
+    CLASS_SPACE = 1,       // [ \t\r\n]
+    CLASS_IDENT_START = 2, // [a-zA-Z_]
+    CLASS_IDENT = 4,       // [a-zA-Z_0-9]
+    CLASS_DIGIT = 8,       // [0-9]
+};
+
+struct CharClasses {
+    unsigned char classes[256] = {};
+
+    CharClasses()
+    {
+        for (unsigned char c : { ' ', '\t', '\r', '\n' }) classes[c] |= CLASS_SPACE;
+        for (int c = 0; c < 256; ++c) {
+            if (isalpha(c) || c == '_') classes[c] |= CLASS_IDENT_START | CLASS_IDENT;
+            if (c >= '0' && c <= '9') classes[c] |= CLASS_IDENT | CLASS_DIGIT;
+        }
+    }
+    inline bool is(char c, unsigned char cls) const { return classes[(unsigned char)c] & cls; }
+};
+
+static const CharClasses charClasses;
+
+static inline bool isContinuation(char c) { return ((unsigned char)c & 0xC0) == 0x80; }
+
+// length of the UTF-8 sequence starting with c (the `.` of the grammar matches a code point)
+static inline size_t codePointLength(char c)
+{
+    unsigned char u = c;
+    return u < 0xC0 ? 1 : u < 0xE0 ? 2 : u < 0xF0 ? 3 : 4;
+}
+
+// ---------------------------------------------------------------- scanners
+
+/*
+    The scanners skip the runs of characters without tokens and return the end of the run.
+    skipSpaces also counts the newlines of the run and keeps the last one, for the lines and columns of the tokens.
+*/
+struct Newlines {
+    size_t count = 0;
+    const char* last = nullptr;
+
+    inline void add(const char* chunk, uint32_t mask)
+    {
+        if (!mask) return;
+        count += __builtin_popcount(mask);
+        last = chunk + 31 - __builtin_clz(mask);
+    }
+};
+
+static const char* skipSpacesScalar(const char* p, const char* end, Newlines& newlines)
+{
+    for (; p < end && charClasses.is(*p, CLASS_SPACE); ++p)
+        if (*p == '\n') newlines.add(p, 1);
+    return p;
+}
+
+// position of "*/", or end
+static const char* findCommentEndScalar(const char* p, const char* end)
+{
+    for (; p + 1 < end; ++p)
+        if (p[0] == '*' && p[1] == '/') return p;
+    return end;
+}
+
+static const char* findNewlineScalar(const char* p, const char* end)
+{
+    for (; p < end; ++p)
+        if (*p == '\n') return p;
+    return end;
+}
+
+#ifdef __SSE2__
+
+static const char* skipSpacesSSE2(const char* p, const char* end, Newlines& newlines)
+{
+    const __m128i space = _mm_set1_epi8(' '), tab = _mm_set1_epi8('\t'), cr = _mm_set1_epi8('\r'), nl = _mm_set1_epi8('\n');
+    for (; end - p >= 16; p += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)p);
+        __m128i newline = _mm_cmpeq_epi8(chunk, nl);
+        __m128i blank = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab)),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, cr), newline));
+        uint32_t other = ~_mm_movemask_epi8(blank) & 0xFFFF;
+        uint32_t newlineMask = _mm_movemask_epi8(newline);
+        if (other) {
+            uint32_t length = __builtin_ctz(other);
+            newlines.add(p, newlineMask & ((1u << length) - 1));
+            return p + length;
+        }
+        newlines.add(p, newlineMask);
+    }
+    return skipSpacesScalar(p, end, newlines);
+}
+
+static const char* findCommentEndSSE2(const char* p, const char* end)
+{
+    const __m128i star = _mm_set1_epi8('*'), slash = _mm_set1_epi8('/');
+    for (; end - p >= 17; p += 16) {
+        __m128i stars = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), star);
+        __m128i slashes = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 1)), slash);
+        uint32_t mask = _mm_movemask_epi8(_mm_and_si128(stars, slashes));
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return findCommentEndScalar(p, end);
+}
+
+static const char* findNewlineSSE2(const char* p, const char* end)
+{
+    const __m128i nl = _mm_set1_epi8('\n');
+    for (; end - p >= 16; p += 16) {
+        uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), nl));
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return findNewlineScalar(p, end);
+}
+
+// same as the SSE2 versions on 32 bytes, only called when the processor supports AVX2
+__attribute__((target("avx2")))
+static const char* skipSpacesAVX2(const char* p, const char* end, Newlines& newlines)
+{
+    const __m256i space = _mm256_set1_epi8(' '), tab = _mm256_set1_epi8('\t'), cr = _mm256_set1_epi8('\r'), nl = _mm256_set1_epi8('\n');
+    for (; end - p >= 32; p += 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)p);
+        __m256i newline = _mm256_cmpeq_epi8(chunk, nl);
+        __m256i blank = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, space), _mm256_cmpeq_epi8(chunk, tab)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, cr), newline));
+        uint32_t other = ~(uint32_t)_mm256_movemask_epi8(blank);
+        uint32_t newlineMask = _mm256_movemask_epi8(newline);
+        if (other) {
+            uint32_t length = __builtin_ctz(other);
+            newlines.add(p, length == 0 ? 0 : newlineMask & (0xFFFFFFFFu >> (32 - length)));
+            return p + length;
+        }
+        newlines.add(p, newlineMask);
+    }
+    return skipSpacesSSE2(p, end, newlines);
+}
+
+__attribute__((target("avx2")))
+static const char* findCommentEndAVX2(const char* p, const char* end)
+{
+    const __m256i star = _mm256_set1_epi8('*'), slash = _mm256_set1_epi8('/');
+    for (; end - p >= 33; p += 32) {
+        __m256i stars = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), star);
+        __m256i slashes = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + 1)), slash);
+        uint32_t mask = _mm256_movemask_epi8(_mm256_and_si256(stars, slashes));
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return findCommentEndSSE2(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* findNewlineAVX2(const char* p, const char* end)
+{
+    const __m256i nl = _mm256_set1_epi8('\n');
+    for (; end - p >= 32; p += 32) {
+        uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), nl));
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return findNewlineSSE2(p, end);
+}
+
+#endif
+
+struct Scanners {
+    const char* (*skipSpaces)(const char*, const char*, Newlines&);
+    const char* (*findCommentEnd)(const char*, const char*);
+    const char* (*findNewline)(const char*, const char*);
+
+    Scanners()
+    {
+#ifdef __SSE2__
+        __builtin_cpu_init(); // this constructor can run before the one of libgcc
+        if (__builtin_cpu_supports("avx2")) {
+            skipSpaces = skipSpacesAVX2;
+            findCommentEnd = findCommentEndAVX2;
+            findNewline = findNewlineAVX2;
+            return;
+        }
+        skipSpaces = skipSpacesSSE2;
+        findCommentEnd = findCommentEndSSE2;
+        findNewline = findNewlineSSE2;
+#else
+        skipSpaces = skipSpacesScalar;
+        findCommentEnd = findCommentEndScalar;
+        findNewline = findNewlineScalar;
+#endif
+    }
+};
+
+static const Scanners scanners;
+
+// ---------------------------------------------------------------- lexer
+
+Lexer::Lexer(std::string_view content, const antlr4::dfa::Vocabulary& vocabulary, std::ostream& diagnostics)
+    : _begin(content.data()), _p(content.data()), _end(content.data() + content.size()),
+    _line(1), _lineStart(content.data()), _continuations(0), _syntaxErrors(0), _diagnostics(diagnostics), _single(), _maxKeywordLength(0)
+{
+    // the implicit tokens of the grammar ('(', 'while', '!'...) and its rules with several alternatives
+    for (size_t type = 1; type <= vocabulary.getMaxTokenType(); ++type) {
+        std::string name = vocabulary.getLiteralName(type);
+        if (name.size() < 2) continue;
+        std::string text = name.substr(1, name.size() - 2); // without the quotes
+        if (charClasses.is(text[0], CLASS_IDENT_START)) _keywords[text] = type;
+        else if (text.size() == 1) _single[(unsigned char)text[0]] = type;
+        else _double[(unsigned char)text[0]].push_back({ text[1], type });
+    }
+    _keywords["int"] = _keywords["char"] = ifccLexer::TYPE;
+    for (char c : { '*', '/', '%' }) _single[(unsigned char)c] = ifccLexer::OP_MULT;
+    for (char c : { '+', '-' }) _single[(unsigned char)c] = ifccLexer::OP_ADD;
+    for (char c : { '<', '>' }) _single[(unsigned char)c] = ifccLexer::OP_COMP;
+    for (char c : { '+', '-' }) {
+        _double[(unsigned char)c].push_back({ '=', ifccLexer::OP_AFF_ADD });
+        _double[(unsigned char)c].push_back({ c, ifccLexer::OP_INCR });
+    }
+    for (char c : { '<', '>' }) _double[(unsigned char)c].push_back({ '=', ifccLexer::OP_COMP });
+    for (char c : { '=', '!' }) _double[(unsigned char)c].push_back({ '=', ifccLexer::OP_EQ });
+    if (!_single[(unsigned char)'('] || _keywords.find("while") == _keywords.end())
+        throw CompileError("the vocabulary is not the one of ifcc.g4");
+    for (const auto& keyword : _keywords) _maxKeywordLength = std::max(_maxKeywordLength, keyword.first.size());
+}
+
+std::unique_ptr<antlr4::Token> Lexer::token(size_t type, const char* start, const char* stop)
+{
+    auto token = std::make_unique<antlr4::CommonToken>(std::make_pair(this, (antlr4::CharStream*)nullptr), type,
+        antlr4::Token::DEFAULT_CHANNEL, start - _begin, stop - _begin - 1);
+    token->setLine(_line);
+    token->setCharPositionInLine(column(start));
+    token->setText(type == antlr4::Token::EOF ? "<EOF>" : std::string(start, stop));
+    return token;
+}
+
+// same message as the ConsoleErrorListener of ANTLR, on the diagnostics
+void Lexer::error(const char* start, const char* stop)
+{
+    std::string text;
+    for (const char* c = start; c <= stop && c < _end; ++c) {
+        if (*c == '\n') text += "\\n";
+        else if (*c == '\r') text += "\\r";
+        else if (*c == '\t') text += "\\t";
+        else text += *c;
+    }
+    _diagnostics << "line " << _line << ":" << column(start) << " token recognition error at: '" << text << "'" << std::endl;
+    ++_syntaxErrors;
+}
+
+void Lexer::newlines(const char* start, const char* stop)
+{
+    Newlines newlines;
+    for (const char* c = scanners.findNewline(start, stop); c < stop; c = scanners.findNewline(c + 1, stop))
+        newlines.add(c, 1);
+    if (newlines.count) {
+        _line += newlines.count;
+        _lineStart = newlines.last + 1;
+        _continuations = 0;
+        start = _lineStart;
+    }
+    for (const char* c = start; c < stop; ++c) _continuations += isContinuation(*c);
+}
+
+std::unique_ptr<antlr4::Token> Lexer::nextToken()
+{
+    while (true) {
+        Newlines skipped;
+        _p = scanners.skipSpaces(_p, _end, skipped);
+        if (skipped.count) {
+            _line += skipped.count;
+            _lineStart = skipped.last + 1;
+            _continuations = 0;
+        }
+        if (_p == _end) return token(antlr4::Token::EOF, _p, _p);
+
+        const char* start = _p;
+        char c = *_p;
+
+        // IDENTIFIER, TYPE and the keywords, which win over IDENTIFIER for the same length
+        if (charClasses.is(c, CLASS_IDENT_START)) {
+            do ++_p; while (_p < _end && charClasses.is(*_p, CLASS_IDENT));
+            size_t type = ifccLexer::IDENTIFIER;
+            if ((size_t)(_p - start) <= _maxKeywordLength) {
+                auto keyword = _keywords.find(std::string(start, _p));
+                if (keyword != _keywords.end()) type = keyword->second;
+            }
+            return token(type, start, _p);
+        }
+
+        if (charClasses.is(c, CLASS_DIGIT)) {
+            do ++_p; while (_p < _end && charClasses.is(*_p, CLASS_DIGIT));
+            return token(ifccLexer::CONST_INT, start, _p);
+        }
+
+        // CONST_CHAR: '\'' . '\''
+        if (c == '\'') {
+            const char* quote = start + 1 < _end ? std::min(start + 1 + codePointLength(start[1]), _end) : _end;
+            if (quote < _end && *quote == '\'') {
+                _p = quote + 1;
+                auto constChar = token(ifccLexer::CONST_CHAR, start, _p);
+                newlines(start, _p);
+                return constChar;
+            }
+            // ANTLR stops at the character which is not the closing quote and skips it
+            error(start, quote);
+            _p = quote < _end ? quote + 1 : _end;
+            newlines(start, _p);
+            continue;
+        }
+
+        // COMMENT: '/*' .*? '*/', an unterminated comment is the operator '/'
+        if (c == '/' && _p + 1 < _end && _p[1] == '*') {
+            const char* commentEnd = scanners.findCommentEnd(_p + 2, _end);
+            if (commentEnd != _end) {
+                _p = commentEnd + 2;
+                newlines(start, _p);
+                continue;
+            }
+        }
+
+        // DIRECTIVE: '#' .*? '\n', without newline it is not a token
+        if (c == '#') {
+            const char* newline = scanners.findNewline(_p + 1, _end);
+            if (newline == _end) error(start, _end - 1);
+            _p = newline == _end ? _end : newline + 1;
+            newlines(start, _p);
+            continue;
+        }
+
+        if (_p + 1 < _end) {
+            for (const auto& [second, type] : _double[(unsigned char)c]) {
+                if (_p[1] == second) {
+                    _p += 2;
+                    return token(type, start, _p);
+                }
+            }
+        }
+        if (size_t type = _single[(unsigned char)c]) {
+            ++_p;
+            return token(type, start, _p);
+        }
+
+        // no rule matches this code point
+        _p += std::min<size_t>(codePointLength(c), _end - _p);
+        error(start, _p - 1);
+        _continuations += _p - start - 1;
+    }
+}
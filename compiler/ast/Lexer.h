@@ -0,0 +1,59 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "antlr4-runtime.h"
+
+namespace ast {
+
+/*
+    Hand-written lexer of ifcc.g4 (--lexer=hand), a TokenSource for the ANTLR token stream
+    usable by both parsers.
+
+    The tokens are the ones of ifccLexer, with the same longest match rules: an unterminated comment
+    is the operator '/', and the characters matched by no rule are reported and skipped like ANTLR does.
+    The whitespaces are skipped instead of being emitted on the hidden channel.
+    The runs of whitespaces, the comments and the directives are scanned 16 bytes (SSE2) or
+    32 bytes (AVX2, when the processor has it) at a time.
+
+    The tokens carry their text, they do not refer to a CharStream, and the columns are counted
+    in code points like in ANTLR.
+*/
+class Lexer : public antlr4::TokenSource {
+public:
+    Lexer(std::string_view content, const antlr4::dfa::Vocabulary& vocabulary, std::ostream& diagnostics = std::cerr);
+
+    std::unique_ptr<antlr4::Token> nextToken() override;
+    size_t getLine() const override { return _line; }
+    size_t getCharPositionInLine() override { return column(_p); }
+    antlr4::CharStream* getInputStream() override { return nullptr; }
+    std::string getSourceName() override { return "<unknown>"; }
+    antlr4::Ref<antlr4::TokenFactory<antlr4::CommonToken>> getTokenFactory() override { return antlr4::CommonTokenFactory::DEFAULT; }
+
+    inline size_t getNumberOfSyntaxErrors() const { return _syntaxErrors; }
+
+protected:
+    inline size_t column(const char* p) const { return p - _lineStart - _continuations; }
+    std::unique_ptr<antlr4::Token> token(size_t type, const char* start, const char* stop);
+    void error(const char* start, const char* stop); // the text of the error is [start, stop]
+    void newlines(const char* start, const char* stop); // updates the line and the column after skipping [start, stop)
+
+    const char* _begin;
+    const char* _p;
+    const char* _end;
+    size_t _line;
+    const char* _lineStart;
+    size_t _continuations; // UTF-8 continuation bytes between _lineStart and _p
+    size_t _syntaxErrors;
+    std::ostream& _diagnostics;
+
+    size_t _single[256]; // token type of the operators of one character, 0 if none
+    std::vector<std::pair<char, size_t>> _double[256]; // second character and token type of the operators of two characters
+    std::unordered_map<std::string, size_t> _keywords; // identifiers which are other tokens ('while', TYPE...)
+    size_t _maxKeywordLength;
+};
+
+}
@@ -0,0 +1,344 @@
+#include <iostream>
+#include "Parser.h"
+#include "../CompileError.h"
+#include "generated/ifccLexer.h"
+
+using namespace ast;
+
+// precedences of the alternatives of `expression`, as numbered by ANTLR (18 alternatives, the first one is 18)
+static const int PREC_UNARY = 15;
+static const int PREC_MULT = 14;
+static const int PREC_ADD = 13;
+static const int PREC_BIT_AND = 12;
+static const int PREC_BIT_XOR = 11;
+static const int PREC_BIT_OR = 10;
+static const int PREC_COMPARE = 8;
+static const int PREC_EQUAL = 7;
+static const int PREC_LAZY_AND = 6;
+static const int PREC_LAZY_OR = 5;
+static const int PREC_ASSIGN = 4;
+static const int PREC_AFF_ADD = 3;
+
+Parser::Parser(antlr4::TokenStream& tokens, const antlr4::dfa::Vocabulary& vocabulary, std::ostream& diagnostics)
+    : _tokens(tokens), _vocabulary(vocabulary), _program(nullptr), _diagnostics(diagnostics), _syntaxErrors(0)
+{
+    for (size_t type = 1; type <= vocabulary.getMaxTokenType(); ++type) {
+        std::string name = vocabulary.getLiteralName(type);
+        if (name.size() >= 2) _literals[name.substr(1, name.size() - 2)] = type; // without the quotes
+    }
+    _lparen = literal("(");
+    _rparen = literal(")");
+    _lbrace = literal("{");
+    _rbrace = literal("}");
+    _comma = literal(",");
+    _semicolon = literal(";");
+    _assign = literal("=");
+    _bitAnd = literal("&");
+    _bitXor = literal("^");
+    _bitOr = literal("|");
+    _lazyAnd = literal("&&");
+    _lazyOr = literal("||");
+    _if = literal("if");
+    _else = literal("else");
+    _while = literal("while");
+}
+
+size_t Parser::literal(const std::string& text) const
+{
+    auto it = _literals.find(text);
+    if (it == _literals.end()) throw CompileError("the token '" + text + "' is not in the grammar");
+    return it->second;
+}
+
+std::unique_ptr<Program> Parser::parseProgram()
+{
+    auto program = std::make_unique<Program>();
+    _program = program.get();
+    try {
+        while (la() != antlr4::Token::EOF) program->functions.push_back(parseFunction());
+    }
+    catch (const SyntaxError&) {
+        ++_syntaxErrors;
+    }
+    return program;
+}
+
+std::unique_ptr<Program> Parser::parseNextFunction()
+{
+    if (la() == antlr4::Token::EOF) return nullptr;
+    auto program = std::make_unique<Program>();
+    _program = program.get();
+    try {
+        program->functions.push_back(parseFunction());
+    }
+    catch (const SyntaxError&) {
+        ++_syntaxErrors;
+        return nullptr;
+    }
+    return program;
+}
+
+// ---------------------------------------------------------------- tokens
+
+antlr4::Token* Parser::consume()
+{
+    antlr4::Token* token = _tokens.LT(1);
+    _tokens.consume();
+    return token;
+}
+
+antlr4::Token* Parser::expect(size_t type)
+{
+    if (la() != type) {
+        std::string expected = _vocabulary.getLiteralName(type);
+        if (expected.empty()) expected = _vocabulary.getSymbolicName(type);
+        error("mismatched input '" + _tokens.LT(1)->getText() + "' expecting " + expected);
+    }
+    return consume();
+}
+
+void Parser::error(const std::string& message)
+{
+    antlr4::Token* token = _tokens.LT(1);
+    _diagnostics << "line " << token->getLine() << ":" << token->getCharPositionInLine() << " " << message << std::endl;
+    throw SyntaxError();
+}
+
+// ---------------------------------------------------------------- statements
+
+// function_def: (TYPE | VOID) IDENTIFIER '(' (TYPE IDENTIFIER (',' TYPE IDENTIFIER)*)? ')' '{' stmt* '}'
+Function Parser::parseFunction()
+{
+    Function function;
+    function.firstToken = _tokens.LT(1)->getTokenIndex();
+    if (la() == ifccLexer::VOID) function.returnsVoid = true;
+    else if (la() != ifccLexer::TYPE) error("mismatched input '" + _tokens.LT(1)->getText() + "' expecting {TYPE, 'void'}");
+    consume();
+    function.name = expect(ifccLexer::IDENTIFIER)->getText();
+
+    expect(_lparen);
+    if (la() == ifccLexer::TYPE) {
+        consume();
+        function.params.push_back(intern(expect(ifccLexer::IDENTIFIER)->getText()));
+        while (la() == _comma) {
+            consume();
+            expect(ifccLexer::TYPE);
+            function.params.push_back(intern(expect(ifccLexer::IDENTIFIER)->getText()));
+        }
+    }
+    expect(_rparen);
+
+    expect(_lbrace);
+    std::vector<Stmt*> body;
+    while (la() != _rbrace) {
+        if (la() == antlr4::Token::EOF) error("mismatched input '<EOF>' expecting '}'");
+        body.push_back(parseStmt());
+    }
+    function.body = _program->list(body);
+    function.lastToken = consume()->getTokenIndex();
+    return function;
+}
+
+Stmt* Parser::parseStmt()
+{
+    size_t type = la();
+
+    // stmt_declaration: TYPE declaration (',' declaration)* ';'
+    if (type == ifccLexer::TYPE) {
+        consume();
+        Stmt* stmt = _program->stmt(StmtKind::Declaration);
+        std::vector<Declarator> declarators;
+        while (true) {
+            Declarator declarator{ intern(expect(ifccLexer::IDENTIFIER)->getText()), nullptr };
+            if (la() == _assign) {
+                consume();
+                declarator.init = parseExpression();
+            }
+            declarators.push_back(declarator);
+            if (la() != _comma) break;
+            consume();
+        }
+        stmt->declarators = _program->list(declarators);
+        expect(_semicolon);
+        return stmt;
+    }
+
+    if (type == _lbrace) return parseBlock();
+
+    // stmt_jump: RETURN expression? ';'
+    if (type == ifccLexer::RETURN) {
+        consume();
+        Stmt* stmt = _program->stmt(StmtKind::Return);
+        if (la() != _semicolon) stmt->expr = parseExpression();
+        expect(_semicolon);
+        return stmt;
+    }
+
+    // stmt_if: 'if' '(' expression ')' stmt ('else' stmt)?
+    if (type == _if) {
+        consume();
+        Stmt* stmt = _program->stmt(StmtKind::If);
+        expect(_lparen);
+        stmt->expr = parseExpression();
+        expect(_rparen);
+        Stmt* then = parseStmt();
+        if (la() == _else) {
+            consume();
+            stmt->body = _program->list({ then, parseStmt() });
+        }
+        else stmt->body = _program->list({ then });
+        return stmt;
+    }
+
+    // stmt_while: 'while' '(' expression ')' stmt_block
+    if (type == _while) {
+        consume();
+        Stmt* stmt = _program->stmt(StmtKind::While);
+        expect(_lparen);
+        stmt->expr = parseExpression();
+        expect(_rparen);
+        if (la() != _lbrace) error("mismatched input '" + _tokens.LT(1)->getText() + "' expecting '{'");
+        stmt->body = _program->list({ parseBlock() });
+        return stmt;
+    }
+
+    // stmt_expression: expression? ';'
+    Stmt* stmt = _program->stmt(StmtKind::Expression);
+    if (type != _semicolon) stmt->expr = parseExpression();
+    expect(_semicolon);
+    return stmt;
+}
+
+// stmt_block: '{' stmt* '}'
+Stmt* Parser::parseBlock()
+{
+    expect(_lbrace);
+    Stmt* stmt = _program->stmt(StmtKind::Block);
+    std::vector<Stmt*> body;
+    while (la() != _rbrace) {
+        if (la() == antlr4::Token::EOF) error("mismatched input '<EOF>' expecting '}'");
+        body.push_back(parseStmt());
+    }
+    stmt->body = _program->list(body);
+    consume();
+    return stmt;
+}
+
+// ---------------------------------------------------------------- expressions
+
+int Parser::binaryPrecedence(BinaryOp& op)
+{
+    size_t type = la();
+    if (type == ifccLexer::OP_MULT) {
+        char c = _tokens.LT(1)->getText()[0];
+        op = c == '*' ? BinaryOp::Mul : c == '/' ? BinaryOp::Div : BinaryOp::Mod;
+        return PREC_MULT;
+    }
+    if (type == ifccLexer::OP_ADD) {
+        op = _tokens.LT(1)->getText()[0] == '+' ? BinaryOp::Add : BinaryOp::Sub;
+        return PREC_ADD;
+    }
+    if (type == ifccLexer::OP_COMP) {
+        std::string text = _tokens.LT(1)->getText();
+        if (text == "<") op = BinaryOp::Lt;
+        else if (text == ">") op = BinaryOp::Gt;
+        else if (text == "<=") op = BinaryOp::Le;
+        else op = BinaryOp::Ge;
+        return PREC_COMPARE;
+    }
+    if (type == ifccLexer::OP_EQ) {
+        op = _tokens.LT(1)->getText()[0] == '=' ? BinaryOp::Eq : BinaryOp::Ne;
+        return PREC_EQUAL;
+    }
+    if (type == _bitAnd) { op = BinaryOp::BitAnd; return PREC_BIT_AND; }
+    if (type == _bitXor) { op = BinaryOp::BitXor; return PREC_BIT_XOR; }
+    if (type == _bitOr) { op = BinaryOp::BitOr; return PREC_BIT_OR; }
+    if (type == _lazyAnd) { op = BinaryOp::LazyAnd; return PREC_LAZY_AND; }
+    if (type == _lazyOr) { op = BinaryOp::LazyOr; return PREC_LAZY_OR; }
+    return -1;
+}
+
+// The binary operators are left associative: the right operand only takes the operators binding tighter
+Expr* Parser::parseExpression(int minPrecedence)
+{
+    Expr* left = parsePrimary();
+    BinaryOp op;
+    int precedence;
+    while ((precedence = binaryPrecedence(op)) >= minPrecedence) {
+        consume();
+        Expr* binary = _program->expr(ExprKind::Binary);
+        binary->op = op;
+        binary->operands = _program->list({ left, parseExpression(precedence + 1) });
+        left = binary;
+    }
+    return left;
+}
+
+Expr* Parser::parsePrimary()
+{
+    size_t type = la();
+
+    if (type == _lparen) {
+        consume();
+        Expr* expr = parseExpression();
+        expect(_rparen);
+        return expr;
+    }
+
+    if (type == ifccLexer::IDENTIFIER) {
+        Symbol name = intern(consume()->getText());
+        size_t next = la();
+        Expr* expr;
+        if (next == ifccLexer::OP_INCR) {
+            expr = _program->expr(consume()->getText() == "++" ? ExprKind::PostIncr : ExprKind::PostDecr);
+        }
+        else if (next == _lparen) {
+            consume();
+            expr = _program->expr(ExprKind::Call);
+            std::vector<Expr*> arguments;
+            if (la() != _rparen) {
+                arguments.push_back(parseExpression());
+                while (la() == _comma) {
+                    consume();
+                    arguments.push_back(parseExpression());
+                }
+            }
+            expr->operands = _program->list(arguments);
+            expect(_rparen);
+        }
+        else if (next == _assign) {
+            consume();
+            expr = _program->expr(ExprKind::Assign);
+            expr->operands = _program->list({ parseExpression(PREC_ASSIGN) });
+        }
+        else if (next == ifccLexer::OP_AFF_ADD) {
+            expr = _program->expr(consume()->getText() == "+=" ? ExprKind::AddAssign : ExprKind::SubAssign);
+            expr->operands = _program->list({ parseExpression(PREC_AFF_ADD) });
+        }
+        else expr = _program->expr(ExprKind::Ident);
+        expr->name = name;
+        return expr;
+    }
+
+    if (type == ifccLexer::OP_INCR) {
+        Expr* expr = _program->expr(consume()->getText() == "++" ? ExprKind::PreIncr : ExprKind::PreDecr);
+        expr->name = intern(expect(ifccLexer::IDENTIFIER)->getText());
+        return expr;
+    }
+
+    if (type == ifccLexer::OP_ADD || type == ifccLexer::OP_NOT) {
+        std::string op = consume()->getText();
+        Expr* expr = _program->expr(op == "!" ? ExprKind::Not : op == "-" ? ExprKind::Negate : ExprKind::Plus);
+        expr->operands = _program->list({ parseExpression(PREC_UNARY) });
+        return expr;
+    }
+
+    if (type == ifccLexer::CONST_INT || type == ifccLexer::CONST_CHAR) {
+        Expr* expr = _program->expr(ExprKind::Const);
+        std::string text = consume()->getText();
+        expr->value = type == ifccLexer::CONST_INT ? intConstant(text) : (int)text[1];
+        return expr;
+    }
+
+    error("no viable alternative at input '" + _tokens.LT(1)->getText() + "'");
+}
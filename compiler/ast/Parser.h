@@ -0,0 +1,62 @@
+#pragma once
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include "antlr4-runtime.h"
+#include "Ast.h"
+
+namespace ast {
+
+/*
+    Hand-written parser of ifcc.g4 (--parser=hand): recursive descent for the statements
+    and precedence climbing (Pratt) for the expressions, on the tokens of the ANTLR lexer.
+
+    The precedences are the ones ANTLR gives to the left-recursive rule `expression`:
+    an alternative binds tighter than the ones after it. Like in ANTLR, the prefix alternatives
+    (unary operators, assignments) are primaries whose operand is parsed at their own precedence,
+    so `a + b = c + d` is `a + (b = (c + d))` and `-a * b` is `(-a) * b`.
+
+    The parser stops at the first syntax error, reported on the diagnostics like ANTLR does.
+*/
+class Parser {
+public:
+    Parser(antlr4::TokenStream& tokens, const antlr4::dfa::Vocabulary& vocabulary, std::ostream& diagnostics = std::cerr);
+
+    std::unique_ptr<Program> parseProgram();
+    // --stream: the next function alone in its own program, null at the end of the input or after a syntax error
+    std::unique_ptr<Program> parseNextFunction();
+    inline size_t getNumberOfSyntaxErrors() const { return _syntaxErrors; }
+
+protected:
+    struct SyntaxError {};
+
+    // tokens
+    size_t literal(const std::string& text) const; // type of an implicit token like '(' or 'while'
+    inline size_t la(ssize_t k = 1) { return _tokens.LA(k); }
+    antlr4::Token* consume();
+    antlr4::Token* expect(size_t type);
+    [[noreturn]] void error(const std::string& message);
+
+    // rules
+    Function parseFunction();
+    Stmt* parseStmt();
+    Stmt* parseBlock();
+    Expr* parseExpression(int minPrecedence = 0);
+    Expr* parsePrimary();
+    int binaryPrecedence(BinaryOp& op); // of the next token, -1 if it is not a binary operator
+
+    antlr4::TokenStream& _tokens;
+    const antlr4::dfa::Vocabulary& _vocabulary;
+    Program* _program; // the nodes are allocated in its arena
+    std::ostream& _diagnostics;
+    std::map<std::string, size_t> _literals;
+    size_t _syntaxErrors;
+
+    // implicit tokens of the grammar, looked up once in the vocabulary
+    size_t _lparen, _rparen, _lbrace, _rbrace, _comma, _semicolon, _assign;
+    size_t _bitAnd, _bitXor, _bitOr, _lazyAnd, _lazyOr, _if, _else, _while;
+};
+
+}
@@ -0,0 +1,71 @@
+#include "SymbolCheck.h"
+
+using namespace ast;
+
+void SymbolCheck::check(const Program& program)
+{
+    _symbols.reset();
+    for (const auto& f : program.functions) function(f);
+}
+
+void SymbolCheck::function(const Function& function)
+{
+    _symbols.beginFunction(function.name, function.params);
+    for (const auto& s : function.body) stmt(*s);
+    _symbols.popContext();
+}
+
+/*
+    The statements are walked with a work stack like the expressions, so the nesting of the blocks is not limited
+    by the native stack: the statements of a body are pushed in reverse order, after the marker closing the context
+    of a block.
+*/
+void SymbolCheck::stmt(const Stmt& root)
+{
+    _pendingStmts.assign(1, &root);
+    while (!_pendingStmts.empty()) {
+        const Stmt* stmt = _pendingStmts.back();
+        _pendingStmts.pop_back();
+        if (!stmt) {
+            _symbols.popContext();
+            continue;
+        }
+
+        switch (stmt->kind) {
+        case StmtKind::Declaration:
+            // the variable is declared before its initializer is visited, like in SymbolMapVisitor::visitDeclaration
+            for (const auto& declarator : stmt->declarators) {
+                _symbols.addVariable(declarator.name);
+                if (declarator.init) expr(*declarator.init);
+            }
+            break;
+
+        case StmtKind::Block:
+            _symbols.pushContext();
+            _pendingStmts.push_back(nullptr);
+            break;
+
+        default:
+            if (stmt->expr) expr(*stmt->expr);
+            break;
+        }
+        for (size_t i = stmt->body.size(); i-- > 0;) _pendingStmts.push_back(stmt->body[i]);
+    }
+}
+
+/*
+    Only the identifiers used as values are checked: the targets of the assignments and increments are not.
+    The expressions are walked with a work stack, in the order of a recursive walk (the node, then its operands
+    from the first one), so the depth of an expression is not limited by the native stack.
+*/
+void SymbolCheck::expr(const Expr& root)
+{
+    _pending.assign(1, &root);
+    while (!_pending.empty()) {
+        const Expr& expr = *_pending.back();
+        _pending.pop_back();
+        if (expr.kind == ExprKind::Ident) _symbols.useVariable(expr.name);
+        else if (expr.kind == ExprKind::Call) _symbols.checkCall(symbolName(expr.name), expr.operands.size());
+        for (size_t i = expr.operands.size(); i-- > 0;) _pending.push_back(expr.operands[i]);
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Ast.h"
+#include "../SymbolMapVisitor.h"
+
+namespace ast {
+
+/*
+    Semantic checks of the AST of the hand-written parser.
+    The tree is walked in the same order as SymbolMapVisitor walks the ANTLR tree and the checks
+    are done by the SymbolMapVisitor itself, so the diagnostics are the same.
+*/
+class SymbolCheck {
+public:
+    SymbolCheck(SymbolMapVisitor& symbols) : _symbols(symbols) {}
+
+    void check(const Program& program);
+    void function(const Function& function); // --stream: the functions are checked one at a time, after a reset of the visitor
+
+protected:
+    void stmt(const Stmt& stmt);
+    void expr(const Expr& expr);
+
+    SymbolMapVisitor& _symbols;
+    std::vector<const Stmt*> _pendingStmts; // work stack of stmt, nullptr closes the context of a block
+    std::vector<const Expr*> _pending; // work stack of expr
+};
+
+}
@@ -0,0 +1,86 @@
+#include <algorithm>
+#include "TokenWindow.h"
+
+using namespace ast;
+
+void TokenWindow::fill(size_t count)
+{
+    while (_tokens.size() < count && !_eof) {
+        std::unique_ptr<antlr4::Token> token = _source->nextToken();
+        if (auto writable = dynamic_cast<antlr4::WritableToken*>(token.get())) writable->setTokenIndex(_fetched);
+        ++_fetched;
+        if (token->getType() == antlr4::Token::EOF) _eof = true;
+        else if (token->getChannel() != antlr4::Token::DEFAULT_CHANNEL) continue;
+        _tokens.push_back(std::move(token));
+    }
+    _maxSize = std::max(_maxSize, _tokens.size());
+}
+
+void TokenWindow::discard()
+{
+    _tokens.erase(_tokens.begin(), _tokens.begin() + _p);
+    _first += _p;
+    _p = 0;
+}
+
+antlr4::Token* TokenWindow::LT(ssize_t k)
+{
+    if (k == 0) return nullptr; // undefined
+    if (k < 0) return (ssize_t)_p + k < 0 ? nullptr : _tokens[_p + k].get();
+    fill(_p + k);
+    if (_p + k > _tokens.size()) return _tokens.back().get(); // the EOF
+    return _tokens[_p + k - 1].get();
+}
+
+size_t TokenWindow::LA(ssize_t i)
+{
+    antlr4::Token* token = LT(i);
+    return token ? token->getType() : antlr4::Token::INVALID_TYPE;
+}
+
+void TokenWindow::consume()
+{
+    if (LA(1) == antlr4::Token::EOF) throw antlr4::IllegalStateException("cannot consume EOF");
+    ++_p;
+}
+
+void TokenWindow::seek(size_t index)
+{
+    if (index < _first) throw antlr4::IllegalStateException("cannot seek before the window of the tokens");
+    fill(index - _first + 1);
+    _p = std::min(index - _first, _tokens.size() - 1);
+}
+
+antlr4::Token* TokenWindow::get(size_t index) const
+{
+    for (const auto& token : _tokens)
+        if (token->getTokenIndex() == index) return token.get();
+    throw antlr4::IndexOutOfBoundsException("token " + std::to_string(index) + " is not in the window");
+}
+
+// the text of the tokens of the window in the interval, the hidden tokens are not kept
+std::string TokenWindow::getText(const antlr4::misc::Interval& interval)
+{
+    std::string text;
+    for (const auto& token : _tokens) {
+        if (token->getType() == antlr4::Token::EOF) break;
+        if ((ssize_t)token->getTokenIndex() >= interval.a && (ssize_t)token->getTokenIndex() <= interval.b) text += token->getText();
+    }
+    return text;
+}
+
+std::string TokenWindow::getText()
+{
+    return getText(antlr4::misc::Interval((ssize_t)0, (ssize_t)_fetched));
+}
+
+std::string TokenWindow::getText(antlr4::RuleContext* ctx)
+{
+    return getText(ctx->getSourceInterval());
+}
+
+std::string TokenWindow::getText(antlr4::Token* start, antlr4::Token* stop)
+{
+    if (!start || !stop) return "";
+    return getText(antlr4::misc::Interval(start->getTokenIndex(), stop->getTokenIndex()));
+}
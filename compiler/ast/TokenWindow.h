@@ -0,0 +1,56 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <string>
+#include "antlr4-runtime.h"
+
+namespace ast {
+
+/*
+    Token stream of the streaming compilation (--stream): unlike CommonTokenStream, which keeps all the tokens
+    of the input, it only keeps the tokens of the default channel since the last call to discard.
+    The driver discards the tokens of each function once it is parsed, so the stream holds the tokens of a
+    single function (and the lookahead of the parser) instead of the whole input.
+
+    The hand-written parser only uses LT, LA and consume. The tokens are numbered (getTokenIndex) like in
+    CommonTokenStream, the hidden ones included, while index and seek count the tokens of the default channel.
+    The tokens before the window cannot be read nor seeked anymore.
+*/
+class TokenWindow : public antlr4::TokenStream {
+public:
+    TokenWindow(antlr4::TokenSource* source) : _source(source), _first(0), _p(0), _fetched(0), _maxSize(0), _eof(false) {}
+
+    void discard(); // releases the tokens before the current one
+    inline size_t getMaxSize() const { return _maxSize; } // largest number of tokens held at once (-fmem-report)
+
+    antlr4::Token* LT(ssize_t k) override;
+    antlr4::Token* get(size_t index) const override;
+    antlr4::TokenSource* getTokenSource() const override { return _source; }
+    std::string getText(const antlr4::misc::Interval& interval) override;
+    std::string getText() override;
+    std::string getText(antlr4::RuleContext* ctx) override;
+    std::string getText(antlr4::Token* start, antlr4::Token* stop) override;
+
+    void consume() override;
+    size_t LA(ssize_t i) override;
+    ssize_t mark() override { return -1; }
+    void release(ssize_t marker) override {}
+    size_t index() override { return _first + _p; }
+    void seek(size_t index) override;
+    size_t size() override { return _first + _tokens.size(); }
+    std::string getSourceName() const override { return _source->getSourceName(); }
+
+private:
+    void fill(size_t count); // fetches the tokens until the window holds `count` of them, or the EOF
+
+    antlr4::TokenSource* _source;
+    std::deque<std::unique_ptr<antlr4::Token>> _tokens; // the window, the tokens of the default channel only
+    size_t _first; // position of _tokens[0] among the tokens of the default channel
+    size_t _p; // current token in the window
+    size_t _fetched; // tokens read from the source, hidden ones included
+    size_t _maxSize;
+    bool _eof;
+};
+
+}
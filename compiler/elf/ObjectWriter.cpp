@@ -0,0 +1,170 @@
+#include <elf.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "ObjectWriter.h"
+
+using namespace elf;
+
+namespace {
+
+// String table, offsets are returned by add
+struct StringTable {
+    StringTable() : data(1, '\0') {}
+    uint32_t add(const std::string& s) {
+        uint32_t offset = data.size();
+        data += s;
+        data += '\0';
+        return offset;
+    }
+    std::string data;
+};
+
+const char* sectionNames[x86::SECTION_COUNT] = { ".text", ".rodata", ".data", ".bss" };
+const char* relaNames[x86::SECTION_COUNT] = { ".rela.text", ".rela.rodata", ".rela.data", ".rela.bss" };
+
+template <typename T>
+void append(std::string& out, const T& value) {
+    out.append((const char*)&value, sizeof(T));
+}
+
+void alignTo(std::string& out, size_t alignment) {
+    out.append((alignment - out.size() % alignment) % alignment, '\0');
+}
+
+}
+
+/*
+    Layout: header, section contents, section header table
+    Sections: null, .text, .rodata, .data, .bss, .rela.* (only if needed), .note.GNU-stack, .symtab, .strtab, .shstrtab
+    Symbols: null, one per section, local symbols, then global symbols (required by sh_info of .symtab).
+    References to local symbols are rewritten as references to their section symbol, like as does.
+*/
+void elf::writeObject(const x86::Encoder& encoder, std::ostream& o)
+{
+    const auto& symbols = encoder.getSymbols();
+    StringTable strtab, shstrtab;
+
+    // symbol table
+    std::vector<Elf64_Sym> elfSymbols(1 + x86::SECTION_COUNT);
+    std::memset(elfSymbols.data(), 0, elfSymbols.size() * sizeof(Elf64_Sym));
+    for (int s = 0; s < x86::SECTION_COUNT; ++s) {
+        elfSymbols[1 + s].st_info = ELF64_ST_INFO(STB_LOCAL, STT_SECTION);
+        elfSymbols[1 + s].st_shndx = 1 + s;
+    }
+    std::vector<size_t> symbolIndex(symbols.size(), 0);
+    for (int pass = 0; pass < 2; ++pass) {
+        bool globals = pass == 1;
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            const auto& symbol = symbols[i];
+            bool global = symbol.global || symbol.section < 0;
+            if (global != globals) continue;
+            // internal labels are not written, their references use the section symbol
+            if (!global && symbol.name.rfind(".L", 0) == 0) continue;
+            Elf64_Sym sym;
+            std::memset(&sym, 0, sizeof(sym));
+            sym.st_name = strtab.add(symbol.name);
+            sym.st_info = ELF64_ST_INFO(global ? STB_GLOBAL : STB_LOCAL, STT_NOTYPE);
+            sym.st_shndx = symbol.section < 0 ? SHN_UNDEF : 1 + symbol.section;
+            sym.st_value = symbol.section < 0 ? 0 : symbol.offset;
+            symbolIndex[i] = elfSymbols.size();
+            elfSymbols.push_back(sym);
+        }
+    }
+    size_t firstGlobal = elfSymbols.size();
+    for (size_t i = 0; i < elfSymbols.size(); ++i) {
+        if (ELF64_ST_BIND(elfSymbols[i].st_info) == STB_GLOBAL) {
+            firstGlobal = i;
+            break;
+        }
+    }
+
+    // relocations, grouped by section
+    std::vector<Elf64_Rela> relas[x86::SECTION_COUNT];
+    for (const auto& relocation : encoder.getRelocations()) {
+        const auto& symbol = symbols[relocation.symbol];
+        Elf64_Rela rela;
+        rela.r_offset = relocation.offset;
+        rela.r_addend = relocation.addend;
+        size_t index = symbolIndex[relocation.symbol];
+        if (symbol.section >= 0 && !symbol.global) {
+            index = 1 + symbol.section;
+            rela.r_addend += symbol.offset;
+        }
+        rela.r_info = ELF64_R_INFO(index, (uint32_t)relocation.type);
+        relas[relocation.section].push_back(rela);
+    }
+
+    // contents
+    std::string out(sizeof(Elf64_Ehdr), '\0');
+    std::vector<Elf64_Shdr> headers(1);
+    std::memset(&headers[0], 0, sizeof(Elf64_Shdr));
+    auto addSection = [&](const std::string& name, uint32_t type, uint64_t flags, const std::string& data, uint64_t size, uint64_t alignment) {
+        Elf64_Shdr header;
+        std::memset(&header, 0, sizeof(header));
+        alignTo(out, alignment ? alignment : 1);
+        header.sh_name = shstrtab.add(name);
+        header.sh_type = type;
+        header.sh_flags = flags;
+        header.sh_offset = out.size();
+        header.sh_size = size;
+        header.sh_addralign = alignment;
+        out += data;
+        headers.push_back(header);
+        return headers.size() - 1;
+    };
+
+    const uint64_t flags[x86::SECTION_COUNT] = { SHF_ALLOC | SHF_EXECINSTR, SHF_ALLOC, SHF_ALLOC | SHF_WRITE, SHF_ALLOC | SHF_WRITE };
+    for (int s = 0; s < x86::SECTION_COUNT; ++s) {
+        const auto& section = encoder.getSection(s);
+        std::string data(section.bytes.begin(), section.bytes.end());
+        addSection(sectionNames[s], s == x86::BSS ? SHT_NOBITS : SHT_PROGBITS, flags[s], data, section.size, section.align);
+    }
+    std::vector<size_t> relaHeaders;
+    for (int s = 0; s < x86::SECTION_COUNT; ++s) {
+        if (relas[s].empty()) continue;
+        std::string data;
+        for (const auto& rela : relas[s]) append(data, rela);
+        size_t index = addSection(relaNames[s], SHT_RELA, SHF_INFO_LINK, data, data.size(), 8);
+        headers[index].sh_entsize = sizeof(Elf64_Rela);
+        headers[index].sh_info = 1 + s;
+        relaHeaders.push_back(index);
+    }
+    addSection(".note.GNU-stack", SHT_PROGBITS, 0, "", 0, 1);
+
+    std::string symtabData;
+    for (const auto& sym : elfSymbols) append(symtabData, sym);
+    size_t symtabIndex = addSection(".symtab", SHT_SYMTAB, 0, symtabData, symtabData.size(), 8);
+    headers[symtabIndex].sh_entsize = sizeof(Elf64_Sym);
+    headers[symtabIndex].sh_info = firstGlobal;
+    size_t strtabIndex = addSection(".strtab", SHT_STRTAB, 0, strtab.data, strtab.data.size(), 1);
+    headers[symtabIndex].sh_link = strtabIndex;
+    for (size_t index : relaHeaders) headers[index].sh_link = symtabIndex;
+
+    uint32_t shstrtabName = shstrtab.add(".shstrtab");
+    size_t shstrtabIndex = addSection("", SHT_STRTAB, 0, shstrtab.data, shstrtab.data.size(), 1);
+    headers[shstrtabIndex].sh_name = shstrtabName;
+
+    alignTo(out, 8);
+    uint64_t sectionHeadersOffset = out.size();
+    for (const auto& header : headers) append(out, header);
+
+    Elf64_Ehdr ehdr;
+    std::memset(&ehdr, 0, sizeof(ehdr));
+    std::memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+    ehdr.e_ident[EI_CLASS] = ELFCLASS64;
+    ehdr.e_ident[EI_DATA] = ELFDATA2LSB;
+    ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+    ehdr.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+    ehdr.e_type = ET_REL;
+    ehdr.e_machine = EM_X86_64;
+    ehdr.e_version = EV_CURRENT;
+    ehdr.e_shoff = sectionHeadersOffset;
+    ehdr.e_ehsize = sizeof(Elf64_Ehdr);
+    ehdr.e_shentsize = sizeof(Elf64_Shdr);
+    ehdr.e_shnum = headers.size();
+    ehdr.e_shstrndx = shstrtabIndex;
+    std::memcpy(&out[0], &ehdr, sizeof(ehdr));
+
+    o.write(out.data(), out.size());
+}
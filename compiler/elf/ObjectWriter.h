@@ -0,0 +1,11 @@
+#pragma once
+
+#include <iostream>
+#include "../x86/Encoder.h"
+
+namespace elf {
+
+// Writes the sections, symbols and relocations of a finished encoder as an ELF64 relocatable object (x86-64)
+void writeObject(const x86::Encoder& encoder, std::ostream& o);
+
+}
@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <iomanip>
+#include "Arena.h"
+
+using namespace IR;
+
+static const size_t FIRST_CHUNK_SIZE = 16 << 10;
+static const size_t MAX_CHUNK_SIZE = 1 << 20;
+
+ArenaStatistics& ArenaStatistics::operator+=(const ArenaStatistics& other)
+{
+    objects += other.objects;
+    bytes += other.bytes;
+    chunks += other.chunks;
+    reserved += other.reserved;
+    return *this;
+}
+
+void ArenaStatistics::print(std::ostream& o, const char* name) const
+{
+    o << name << " arena: " << objects << " objects, " << std::fixed << std::setprecision(1) << bytes / 1024.0 << " KiB allocated in "
+        << chunks << " chunks (" << reserved / 1024.0 << " KiB reserved)" << std::endl;
+}
+
+Arena::~Arena()
+{
+    for (Destructor* d = _destructors; d; d = d->next) d->destroy(d->object);
+}
+
+std::string_view Arena::copyString(std::string_view text)
+{
+    ++_statistics.objects;
+    char* copy = (char*)allocate(text.size(), 1);
+    memcpy(copy, text.data(), text.size());
+    return std::string_view(copy, text.size());
+}
+
+void* Arena::allocate(size_t size, size_t alignment)
+{
+    size_t padding = (alignment - (size_t)_current % alignment) % alignment;
+    if (!_current || padding + size > (size_t)(_end - _current)) {
+        // the chunks double up to MAX_CHUNK_SIZE, the larger objects have their own chunk
+        size_t chunkSize = _chunks.empty() ? FIRST_CHUNK_SIZE : std::min(MAX_CHUNK_SIZE, 2 * _statistics.reserved / _chunks.size());
+        if (chunkSize < size + alignment) chunkSize = size + alignment;
+        _chunks.push_back(std::unique_ptr<char[]>(new char[chunkSize])); // not zeroed
+        _current = _chunks.back().get();
+        _end = _current + chunkSize;
+        ++_statistics.chunks;
+        _statistics.reserved += chunkSize;
+        padding = (alignment - (size_t)_current % alignment) % alignment;
+    }
+    void* memory = _current + padding;
+    _current += padding + size;
+    _statistics.bytes += padding + size;
+    return memory;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace IR {
+
+// Allocations of one or several arenas (-fmem-report)
+struct ArenaStatistics {
+    size_t objects = 0; // calls to create and copyString
+    size_t bytes = 0; // bytes of these objects, alignment included
+    size_t chunks = 0;
+    size_t reserved = 0; // bytes of the chunks
+
+    ArenaStatistics& operator+=(const ArenaStatistics& other);
+    void print(std::ostream& o, const char* name = "IR") const;
+};
+
+/*
+    Bump allocator of the IR of a ControlFlowGraph: blocks, instructions, variables and labels,
+    also used for the nodes of the AST (ast/Ast.h).
+    The objects are allocated one after the other in chunks of growing size and are all destroyed at once
+    with the arena. The objects which have a destructor are preceded by a node of the list of destructors,
+    called in the reverse order of the allocations.
+
+    An arena is used by a single thread: each function compiled in parallel (-j N) has its own graph.
+*/
+class Arena {
+public:
+    Arena() : _current(nullptr), _end(nullptr), _destructors(nullptr) {}
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    ~Arena();
+
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        ++_statistics.objects;
+        if (std::is_trivially_destructible<T>::value)
+            return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+        // the node is placed right before the object, both in the same allocation
+        constexpr size_t offset = (sizeof(Destructor) + alignof(T) - 1) / alignof(T) * alignof(T);
+        char* memory = (char*)allocate(offset + sizeof(T), alignof(T) > alignof(Destructor) ? alignof(T) : alignof(Destructor));
+        T* object = new (memory + offset) T(std::forward<Args>(args)...);
+        _destructors = new (memory) Destructor{ [](void* p) { ((T*)p)->~T(); }, object, _destructors };
+        return object;
+    }
+
+    // copy of a string in the arena, without terminating '\0'
+    std::string_view copyString(std::string_view text);
+
+    // copy of an array of objects without destructor, nullptr if it is empty
+    template <typename T>
+    T* copyArray(const T* items, size_t count) {
+        static_assert(std::is_trivially_copyable<T>::value, "the arrays are copied with memcpy and never destroyed");
+        if (count == 0) return nullptr;
+        ++_statistics.objects;
+        T* copy = (T*)allocate(count * sizeof(T), alignof(T));
+        memcpy(copy, items, count * sizeof(T));
+        return copy;
+    }
+
+    inline const ArenaStatistics& getStatistics() const { return _statistics; }
+
+private:
+    struct Destructor {
+        void (*destroy)(void*);
+        void* object;
+        Destructor* next;
+    };
+
+    void* allocate(size_t size, size_t alignment);
+
+    char* _current;
+    char* _end;
+    std::vector<std::unique_ptr<char[]>> _chunks;
+    Destructor* _destructors;
+    ArenaStatistics _statistics;
+};
+
+}
@@ -0,0 +1,80 @@
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+#include <fcntl.h>
+#include <unistd.h>
+#include "AsmBuffer.h"
+
+using namespace IR;
+
+static const size_t FIRST_CAPACITY = 64 << 10;
+
+AsmBuffer::AsmBuffer(AsmBuffer&& other) noexcept : _data(other._data), _size(other._size), _capacity(other._capacity)
+{
+    other._data = nullptr;
+    other._size = other._capacity = 0;
+}
+
+AsmBuffer& AsmBuffer::operator=(AsmBuffer&& other) noexcept
+{
+    if (this != &other) {
+        free(_data);
+        _data = other._data;
+        _size = other._size;
+        _capacity = other._capacity;
+        other._data = nullptr;
+        other._size = other._capacity = 0;
+    }
+    return *this;
+}
+
+AsmBuffer::~AsmBuffer()
+{
+    free(_data);
+}
+
+// the capacity doubles, realloc can often extend the buffer in place
+void AsmBuffer::grow(size_t n)
+{
+    size_t capacity = _capacity ? _capacity : FIRST_CAPACITY;
+    while (capacity - _size < n) capacity *= 2;
+    char* data = (char*)realloc(_data, capacity);
+    if (!data) throw std::bad_alloc();
+    _data = data;
+    _capacity = capacity;
+}
+
+// the digits are written backwards in a small buffer, then appended
+AsmBuffer& AsmBuffer::integer(unsigned long value)
+{
+    char digits[20];
+    char* p = digits + sizeof(digits);
+    do {
+        *--p = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    return append(p, digits + sizeof(digits) - p);
+}
+
+AsmBuffer& AsmBuffer::integer(long value)
+{
+    if (value >= 0) return integer((unsigned long)value);
+    *this << '-';
+    return integer(0UL - (unsigned long)value);
+}
+
+bool AsmBuffer::writeFile(const std::filesystem::path& path) const
+{
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) return false;
+    for (size_t written = 0; written < _size;) {
+        ssize_t n = ::write(fd, _data + written, _size - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            close(fd);
+            return false;
+        }
+        written += n;
+    }
+    return close(fd) == 0;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string_view>
+
+namespace IR {
+
+/*
+    Output of the assembly (-S). The code generation formats the instructions directly at the end of a single
+    contiguous buffer, the integers included, without std::ostream nor temporary strings, and the whole buffer
+    is written to the output file with one system call.
+
+    The length of the string literals is known at compile time, the other strings are appended as std::string_view.
+*/
+class AsmBuffer {
+public:
+    AsmBuffer() : _data(nullptr), _size(0), _capacity(0) {}
+    AsmBuffer(AsmBuffer&& other) noexcept;
+    AsmBuffer& operator=(AsmBuffer&& other) noexcept;
+    AsmBuffer(const AsmBuffer&) = delete;
+    AsmBuffer& operator=(const AsmBuffer&) = delete;
+    ~AsmBuffer();
+
+    template <size_t N>
+    inline AsmBuffer& operator<<(const char (&literal)[N]) { return append(literal, N - 1); }
+    inline AsmBuffer& operator<<(std::string_view s) { return append(s.data(), s.size()); }
+    inline AsmBuffer& operator<<(char c) {
+        reserve(1);
+        _data[_size++] = c;
+        return *this;
+    }
+    inline AsmBuffer& operator<<(unsigned char c) { return *this << (char)c; }
+    inline AsmBuffer& operator<<(int value) { return integer((long)value); }
+    inline AsmBuffer& operator<<(unsigned value) { return integer((unsigned long)value); }
+    inline AsmBuffer& operator<<(long value) { return integer(value); }
+    inline AsmBuffer& operator<<(unsigned long value) { return integer(value); }
+
+    inline AsmBuffer& append(const char* s, size_t n) {
+        reserve(n);
+        memcpy(_data + _size, s, n);
+        _size += n;
+        return *this;
+    }
+    inline void reserve(size_t n) { if (_capacity - _size < n) grow(n); }
+
+    inline const char* data() const { return _data; }
+    inline size_t size() const { return _size; }
+    inline std::string_view view() const { return std::string_view(_data, _size); }
+    inline void clear() { _size = 0; }
+
+    bool writeFile(const std::filesystem::path& path) const; // false if the file cannot be written
+    inline void write(std::ostream& o) const { o.write(_data, _size); }
+
+private:
+    void grow(size_t n);
+    AsmBuffer& integer(long value);
+    AsmBuffer& integer(unsigned long value);
+
+    char* _data;
+    size_t _size;
+    size_t _capacity;
+};
+
+}
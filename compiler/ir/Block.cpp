@@ -1,8 +1,15 @@
 #include "Block.h"
 #include "ControlFlowGraph.h"
+#include "Instruction.h"
+#include "Interpreter.h"
 using namespace IR;
 
-BasicBlock::BasicBlock(ControlFlowGraph& cfg, std::string label) :cfg(cfg), label(label), exitTrue(nullptr), exitFalse(nullptr) {}
+BasicBlock::BasicBlock(ControlFlowGraph& cfg, Arena& arena, std::string_view label, int number) :label(label), number(number), exitTrue(nullptr), exitFalse(nullptr), cfg(cfg), arena(arena) {}
+
+std::string BasicBlock::getLabel() const
+{
+    return number < 0 ? std::string(label) : cfg.getBlockLabel(number);
+}
 
 std::string extractFunctionName(const std::string& s) {
     size_t pos = s.find('(');
@@ -14,15 +21,132 @@ std::string extractFunctionName(const std::string& s) {
 
 void BasicBlock::generateAsm(std::ostream& o)
 {
-    o << ".globl " << extractFunctionName(label) << "\n";
-    o << extractFunctionName(label) << ":" << "\n";
+    std::string name = extractFunctionName(getLabel());
+    o << ".globl " << name << "\n";
+    o << name << ":" << "\n";
 
-    if (exitTrue) addInstruction<BrTrue>(*exitTrue);
-    if (exitFalse) addInstruction<Br>(*exitFalse);
     for (auto&& inst : instructions) {
-        inst.get()->generateAsm(o);
+        inst->generateAsm(o);
+    }
+    if (exitTrue) BrTrue(*this, *exitTrue).generateAsm(o);
+    if (exitFalse) Br(*this, *exitFalse).generateAsm(o);
+}
+void BasicBlock::generateCode(x86::Encoder& e)
+{
+    std::string name = extractFunctionName(getLabel());
+    e.bind(name, name.rfind(".L", 0) != 0);
+
+    for (auto&& inst : instructions) {
+        inst->generateCode(e);
+    }
+    if (exitTrue) BrTrue(*this, *exitTrue).generateCode(e);
+    if (exitFalse) Br(*this, *exitFalse).generateCode(e);
+}
+
+/*
+    A call putchar(c) with a constant argument is generated by CFGVisitor as:
+        LdConst c; Store tmp; MovToReg tmp, %edi; CallFunc putchar(tmp)
+    Runs of at least two of those calls are replaced by a PutString writing all the characters at once.
+    The temporaries are only used by their call so they can be dropped.
+*/
+void BasicBlock::coalescePutchar()
+{
+    auto matchPutchar = [this](size_t i, std::string& text) {
+        if (i + 3 >= instructions.size()) return false;
+        if (instructions[i]->getOpcode() != Opcode::LdConst || instructions[i + 1]->getOpcode() != Opcode::Store
+            || instructions[i + 2]->getOpcode() != Opcode::MovToReg || instructions[i + 3]->getOpcode() != Opcode::CallFunc)
+            return false;
+        auto ldConst = static_cast<const LdConst*>(instructions[i]);
+        auto store = static_cast<const Store*>(instructions[i + 1]);
+        auto movToReg = static_cast<const MovToReg*>(instructions[i + 2]);
+        auto callFunc = static_cast<const CallFunc*>(instructions[i + 3]);
+        if (callFunc->getName() != "putchar" || callFunc->getVarList().size() != 1) return false;
+        if (callFunc->getVarList()[0].offset != store->getLoc().offset) return false;
+        if (movToReg->getRegister() != "%edi" || movToReg->getVar().offset != store->getLoc().offset) return false;
+        text += (char)ldConst->getValue();
+        return true;
+    };
+
+    std::vector<Instruction*> result;
+    size_t i = 0;
+    while (i < instructions.size()) {
+        std::string text;
+        size_t end = i;
+        while (matchPutchar(end, text)) end += 4;
+
+        if (text.size() >= 2) {
+            result.push_back(arena.create<PutString>(*this, text, cfg.createString()));
+            i = end;
+        }
+        else result.push_back(instructions[i++]);
     }
+    instructions = std::move(result);
 }
+
+/*
+    A call f(c0, c1...) with constant arguments is generated by CFGVisitor as:
+        LdConst c0; Store t0; LdConst c1; Store t1; ...; MovToReg and PushQ for the arguments; CallFunc f(t0, t1...)
+    If f is pure (see SymbolMapVisitor::getPureFunctions), the whole sequence is replaced by LdConst f(c0, c1...).
+    The evaluator runs f in the interpreter with I/O disabled and bounded steps and depth:
+    if it fails (limit reached, division by zero...) the call is kept.
+    A folded call can be the argument of another one, so the evaluation works on a copy of the instruction list
+    where the folded calls are constants, and the block itself is only rewritten by foldPureCalls. The calls of
+    all the blocks are thus evaluated on the program before folding, whatever the order of the blocks.
+*/
+std::vector<FoldedInstruction> BasicBlock::evaluatePureCalls(const std::set<std::string>& pureFunctions, Interpreter& evaluator) const
+{
+    std::vector<FoldedInstruction> folded;
+    for (size_t i = 0; i < instructions.size(); ++i) folded.push_back({ i, false, 0 });
+    auto instruction = [&](size_t i) { return folded[i].folded ? nullptr : instructions[folded[i].index]; };
+    auto is = [&](size_t i, Opcode opcode) { return !folded[i].folded && instructions[folded[i].index]->getOpcode() == opcode; };
+    auto constant = [&](size_t i, int& value) {
+        if (is(i, Opcode::LdConst)) value = static_cast<const LdConst*>(instruction(i))->getValue();
+        else if (folded[i].folded) value = folded[i].value;
+        else return false;
+        return true;
+    };
+
+    bool changed = false;
+    for (size_t i = 0; i < folded.size(); ++i) {
+        if (!is(i, Opcode::CallFunc)) continue;
+        auto callFunc = static_cast<const CallFunc*>(instruction(i));
+        if (pureFunctions.find(callFunc->getName()) == pureFunctions.end()) continue;
+
+        size_t start = i;
+        while (start > 0 && (is(start - 1, Opcode::MovToReg) || is(start - 1, Opcode::PushQ)))
+            --start;
+        const auto& vars = callFunc->getVarList();
+        if (start < 2 * vars.size()) continue;
+        start -= 2 * vars.size();
+
+        std::vector<int> args;
+        for (size_t j = 0; j < vars.size(); ++j) {
+            int value;
+            if (!constant(start + 2 * j, value) || !is(start + 2 * j + 1, Opcode::Store)) break;
+            if (static_cast<const Store*>(instruction(start + 2 * j + 1))->getLoc().offset != vars[j].offset) break;
+            args.push_back(value);
+        }
+        int result;
+        if (args.size() != vars.size() || !evaluator.run(callFunc->getName(), args, result)) continue;
+
+        folded[start] = { 0, true, result };
+        folded.erase(folded.begin() + start + 1, folded.begin() + i + 1);
+        i = start;
+        changed = true;
+    }
+    if (!changed) folded.clear();
+    return folded;
+}
+
+void BasicBlock::foldPureCalls(const std::vector<FoldedInstruction>& folded)
+{
+    if (folded.empty()) return;
+    std::vector<Instruction*> result;
+    for (const auto& f : folded)
+        result.push_back(f.folded ? arena.create<LdConst>(*this, f.value) : instructions[f.index]);
+    instructions = std::move(result);
+}
+
 void IR::BasicBlock::setExit(BasicBlock& block)
 {
     exitTrue = nullptr;
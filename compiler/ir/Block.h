@@ -3,13 +3,23 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <set>
 #include <iostream>
 #include <memory>
 #include "Instruction.h"
+#include "Arena.h"
 
 namespace IR {
 
 class ControlFlowGraph;
+class Interpreter;
+
+// An instruction of a block once its pure calls are folded: an instruction of the block, or the value of a folded call
+struct FoldedInstruction {
+    size_t index; // index of the instruction in the block, if not folded
+    bool folded;
+    int value; // result of the call, if folded
+};
 
 //   The class for a basic block
 
@@ -45,29 +55,41 @@ private:
 
 class BasicBlock {
 public:
-    BasicBlock(ControlFlowGraph& cfg, std::string label);
+    BasicBlock(ControlFlowGraph& cfg, Arena& arena, std::string_view label, int number = -1);
 
     template <typename TInst, typename... IArgs>
     TInst& addInstruction(IArgs&&... args) {
-        auto ptr = std::make_unique<TInst>(*this, args...);
-        instructions.push_back(std::move(ptr));
-        return *((TInst*)instructions[instructions.size()-1].get());
+        TInst* instruction = arena.create<TInst>(*this, std::forward<IArgs>(args)...);
+        instructions.push_back(instruction);
+        return *instruction;
     }
     
     void generateAsm(std::ostream& o); // < x86 assembly code generation for this basic block (very simple)
+    void generateCode(x86::Encoder& e); // < x86-64 machine code generation, same code as generateAsm
+
+    // Optimization passes
+    void coalescePutchar(); // < replaces runs of putchar calls with constant arguments by a single PutString
+    // < evaluates the calls of pure functions with constant arguments, returns the instructions of the folded block (empty if nothing is folded)
+    std::vector<FoldedInstruction> evaluatePureCalls(const std::set<std::string>& pureFunctions, Interpreter& evaluator) const;
+    void foldPureCalls(const std::vector<FoldedInstruction>& folded); // < replaces the instructions by the ones returned by evaluatePureCalls
 
     inline ControlFlowGraph& getCFG() { return cfg; }
 
-    inline std::string getLabel() { return label; }
+    std::string getLabel() const;
+    inline const std::vector<Instruction*>& getInstructions() const { return instructions; }
+    inline const BasicBlock* getExitTrue() const { return exitTrue; }
+    inline const BasicBlock* getExitFalse() const { return exitFalse; }
     void setExit(BasicBlock& block);
     void setExitTrue(BasicBlock& block);
     void setExitFalse(BasicBlock& block);
 
 protected:
-    std::string label; // label of the BB, also will be the label in the generated code
-    std::vector<std::unique_ptr<Instruction>> instructions; // the instructions themselves.
+    std::string_view label; // label of the BB, also will be the label in the generated code (in the arena of the graph)
+    int number; // the blocks without label are numbered by their graph, their label is given by ControlFlowGraph::getBlockLabel
+    std::vector<Instruction*> instructions; // the instructions themselves, allocated in the arena of the graph
     BasicBlock* exitTrue;  // pointer to the next basic block, true branch. If nullptr, return from procedure
     BasicBlock* exitFalse; // pointer to the next basic block, false branch. If null_ptr, the basic block ends with an unconditional jump
     ControlFlowGraph& cfg; // the ControlFlowGraph where this block belongs
+    Arena& arena; // the arena of cfg
 };
 }
\ No newline at end of file
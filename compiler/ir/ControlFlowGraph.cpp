@@ -1,26 +1,121 @@
 #include "ControlFlowGraph.h"
+#include "Runtime.h"
+#include "Interpreter.h"
+#include "DenseIR.h"
+#include "../CompileError.h"
+#include <sstream>
 using namespace IR;
 
-ControlFlowGraph::ControlFlowGraph() : _memorySize(0), _tmpCount(0) {}
+ControlFlowGraph::ControlFlowGraph(const Options& options) : _options(options), _memorySize(0), _stringCount(0), _blockCount(0), _firstBlockNumber(0), _firstStringNumber(0) {}
 ControlFlowGraph::~ControlFlowGraph() {}
 
-void ControlFlowGraph::generateAsm(std::ostream& o) const
+void ControlFlowGraph::generateAsm(AsmBuffer& o) const
 {
+    generateFunctionsAsm(o);
+    if (_options.freestanding) generateFreestandingRuntime(o);
+}
+
+void ControlFlowGraph::generateCode(x86::Encoder& e) const
+{
+    generateFunctionsCode(e);
+    if (_options.freestanding) generateFreestandingRuntime(e);
+}
+
+void ControlFlowGraph::generateFunctionsAsm(AsmBuffer& o) const
+{
+    if (!_options.objectIR) {
+        DenseGraph(*this).generateAsm(o);
+        return;
+    }
+    std::ostringstream output;
     for (auto&& block : _blocks) {
-        block.get()->generateAsm(o);
+        block->generateAsm(output);
     }
+    o << output.str();
+}
+
+void ControlFlowGraph::generateFunctionsCode(x86::Encoder& e) const
+{
+    for (auto&& block : _blocks) {
+        block->generateCode(e);
+    }
+}
+
+// bounds of the compile-time evaluation of the pure calls: each call, and all the calls of the unit,
+// which share a single evaluator
+const uint64_t EVAL_MAX_STEPS = 1000000;
+const size_t EVAL_MAX_DEPTH = 1000;
+const uint64_t EVAL_MAX_TOTAL_STEPS = 10000000;
+
+// the evaluators never read or write, their streams can be shared
+static std::istringstream noInput;
+static std::ostringstream noOutput;
+
+std::unique_ptr<Interpreter> ControlFlowGraph::createEvaluator(const std::vector<const ControlFlowGraph*>& program)
+{
+    auto evaluator = std::make_unique<Interpreter>(program, noInput, noOutput);
+    evaluator->setIOAllowed(false);
+    evaluator->setLimits(EVAL_MAX_STEPS, EVAL_MAX_DEPTH, EVAL_MAX_TOTAL_STEPS);
+    return evaluator;
+}
+
+void ControlFlowGraph::optimize(const std::set<std::string>& pureFunctions)
+{
+    // nothing to evaluate: no evaluator, whose stack is allocated and cleared (--stream optimizes each function alone)
+    if (pureFunctions.empty()) {
+        optimize(std::vector<std::vector<FoldedInstruction>>(_blocks.size()));
+        return;
+    }
+    auto evaluator = createEvaluator({ this });
+    optimize(evaluatePureCalls(pureFunctions, *evaluator));
+}
+
+std::vector<std::vector<FoldedInstruction>> ControlFlowGraph::evaluatePureCalls(const std::set<std::string>& pureFunctions, Interpreter& evaluator) const
+{
+    std::vector<std::vector<FoldedInstruction>> folded;
+    for (auto&& block : _blocks) {
+        folded.push_back(block->evaluatePureCalls(pureFunctions, evaluator));
+    }
+    return folded;
+}
+
+void ControlFlowGraph::optimize(const std::vector<std::vector<FoldedInstruction>>& folded)
+{
+    for (size_t i = 0; i < _blocks.size(); ++i) {
+        _blocks[i]->foldPureCalls(folded[i]);
+        _blocks[i]->coalescePutchar();
+    }
+}
+
+int ControlFlowGraph::createString()
+{
+    return _stringCount++;
+}
+
+std::string ControlFlowGraph::getBlockLabel(int number) const
+{
+    return ".L" + std::to_string(_firstBlockNumber + number);
+}
+
+std::string ControlFlowGraph::getStringLabel(int number) const
+{
+    return ".Lstr" + std::to_string(_firstStringNumber + number);
+}
+
+void ControlFlowGraph::setFirstLabelNumbers(int block, int string)
+{
+    _firstBlockNumber = block;
+    _firstStringNumber = string;
 }
 
 void ControlFlowGraph::pushContext()
 {
-    _contextSymbolMaps.push_back(std::map<std::string, Variable*>());
-    _contextTmpMaps.push_back(std::map<std::string, Variable*>());
+    _symbols.pushScope();
 }
 
 void ControlFlowGraph::popContext()
 {
-    _contextSymbolMaps.pop_back();
-    _contextTmpMaps.pop_back();
+    _symbols.popScope();
 }
 
 BasicBlock& ControlFlowGraph::createAndAddBlock(std::string label) {
@@ -28,62 +123,51 @@ BasicBlock& ControlFlowGraph::createAndAddBlock(std::string label) {
     return getCurrentBlock();
 }
 
-std::unique_ptr<BasicBlock> ControlFlowGraph::createBlock(std::string label) {
-    static int _nextBlocknumber = 0; // just for naming
-    if (label == "") label = ".L" + std::to_string(_nextBlocknumber++);
-    return std::make_unique<BasicBlock>(*this, label);
+BasicBlock* ControlFlowGraph::createBlock(std::string label) {
+    if (label == "") return _arena.create<BasicBlock>(*this, _arena, std::string_view(), _blockCount++);
+    return _arena.create<BasicBlock>(*this, _arena, _arena.copyString(label));
 }
 
-void ControlFlowGraph::addBlock(std::unique_ptr<BasicBlock> block) {
-    _blocks.push_back(std::move(block));
+void ControlFlowGraph::addBlock(BasicBlock* block) {
+    _blocks.push_back(block);
 }
 
-const Variable& ControlFlowGraph::createSymbolVar(std::string name)
+const Variable& ControlFlowGraph::createSymbolVar(Symbol name)
 {
-    auto variable = std::make_shared<Variable>(name, reserveSpace(4));
-    _symbols.push_back(variable);
-    _contextSymbolMaps[_contextSymbolMaps.size() - 1][name] = variable.get();
-    return *variable.get();
+    Variable* variable = createVariable(name, reserveSpace(4));
+    _symbols.declare(name, variable);
+    return *variable;
 }
 
-const Variable& ControlFlowGraph::createSymbolVar(std::string name, int address)
+const Variable& ControlFlowGraph::createSymbolVar(Symbol name, int address)
 {
-    auto variable = std::make_shared<Variable>(name, address);
-    _symbols.push_back(variable);
-    _contextSymbolMaps[_contextSymbolMaps.size() - 1][name] = variable.get();
-    return *variable.get();
+    Variable* variable = createVariable(name, address);
+    _symbols.declare(name, variable);
+    return *variable;
 }
 
 const Variable& ControlFlowGraph::createTmpVar()
 {
-    std::string name = "!" + std::to_string(_tmpCount++);
-    auto variable = std::make_shared<Variable>(name, reserveSpace(4));
-    _symbols.push_back(variable);
-    _contextTmpMaps[_contextTmpMaps.size() - 1][name] = variable.get();
-    return *variable.get();
-}
-
-const Variable& IR::ControlFlowGraph::getSymbolVar(std::string varname)
-{
-    for (int i = _contextSymbolMaps.size() - 1; i >= 0; i--) {
-        const auto& tmpMap = _contextTmpMaps.at(i);
-        const auto& symbolMap = _contextSymbolMaps[i];
-        switch (varname[0]) {
-        case '!': {}
-                if (tmpMap.find(varname) != tmpMap.end()) return *tmpMap.at(varname);
-                break;
-        default:
-            if (symbolMap.find(varname) != symbolMap.end()) return *symbolMap.at(varname);
-            break;
-        }
-    }
-    std::cerr << "error: Undefined variable (something went very wrong)." << std::endl;
-    exit(1);
+    return *createVariable(NO_SYMBOL, reserveSpace(4));
+}
+
+const Variable& IR::ControlFlowGraph::getSymbolVar(Symbol name)
+{
+    Variable** variable = _symbols.lookup(name);
+    if (variable) return **variable;
+    throw CompileError("Undefined variable (something went very wrong).");
 }
 
 BasicBlock& ControlFlowGraph::getCurrentBlock() const
 {
-    return *_blocks.at(_blocks.size() - 1).get();
+    return *_blocks.at(_blocks.size() - 1);
+}
+
+Variable* ControlFlowGraph::createVariable(Symbol name, int offset)
+{
+    Variable* variable = _arena.create<Variable>(name, offset, (uint32_t)_variables.size());
+    _variables.push_back(variable);
+    return variable;
 }
 
 int ControlFlowGraph::reserveSpace(int size)
@@ -6,7 +6,10 @@
 #include <iostream>
 #include <initializer_list>
 #include "Block.h"
+#include "AsmBuffer.h"
 #include <memory>
+#include "../Options.h"
+#include "../ScopedSymbolTable.h"
 
 namespace IR {
 
@@ -17,49 +20,75 @@ namespace IR {
      (again it could be identified in a more explicit way)
 `
 */
-struct Variable {
-    Variable(std::string name, int offset) : name(name), offset(offset) {}
-    std::string name;
-    int offset;
-};
-
 class ControlFlowGraph {
 public:
-    ControlFlowGraph();
+    ControlFlowGraph(const Options& options);
     ~ControlFlowGraph();
 
-    std::unique_ptr<BasicBlock> createBlock(std::string label = "");
-    void addBlock(std::unique_ptr<BasicBlock> block);
+    inline const Options& getOptions() const { return _options; }
+
+    BasicBlock* createBlock(std::string label = ""); // without a label, the block is numbered (.L<n>)
+    void addBlock(BasicBlock* block);
     BasicBlock& createAndAddBlock(std::string label = "");
+    inline const std::vector<BasicBlock*>& getBlocks() const { return _blocks; }
+    inline const ArenaStatistics& getArenaStatistics() const { return _arena.getStatistics(); }
 
     // x86 code generation: could be encapsulated in a processor class in a retargetable compiler
-    void generateAsm(std::ostream& o) const;
+    void generateAsm(AsmBuffer& o) const;
+    void generateCode(x86::Encoder& e) const; // -c: machine code for the ELF writer, the encoder must be finished by the caller
+    // the same without the freestanding runtime, for the graphs of the functions compiled in parallel (-j N)
+    void generateFunctionsAsm(AsmBuffer& o) const;
+    void generateFunctionsCode(x86::Encoder& e) const;
+
+    // Runs the optimization passes on every block (-O)
+    void optimize(const std::set<std::string>& pureFunctions);
+    // The same in two steps for the graphs of the functions compiled in parallel: the pure calls of all the graphs
+    // are evaluated before any of them is folded, then each graph is optimized with its own evaluation
+    static std::unique_ptr<Interpreter> createEvaluator(const std::vector<const ControlFlowGraph*>& program);
+    std::vector<std::vector<FoldedInstruction>> evaluatePureCalls(const std::set<std::string>& pureFunctions, Interpreter& evaluator) const;
+    void optimize(const std::vector<std::vector<FoldedInstruction>>& folded);
+
+    // Labels of the numbered blocks and of the constant strings. When the functions of a translation unit have
+    // their own graphs (-j N), the numbers of a graph start after the ones used by the graphs before it,
+    // so that the labels are the same as with a single graph.
+    int createString(); // number of a new constant string in .rodata
+    std::string getBlockLabel(int number) const;
+    std::string getStringLabel(int number) const;
+    inline int getBlockCount() const { return _blockCount; }
+    inline int getStringCount() const { return _stringCount; }
+    void setFirstLabelNumbers(int block, int string);
 
     // symbol table methods
     void pushContext();
     void popContext();
-    const Variable& createSymbolVar(std::string name /*, Type t*/);
-    const Variable& createSymbolVar(std::string name, int address /*, Type t*/);
-    const Variable& getSymbolVar(std::string name);
+    const Variable& createSymbolVar(Symbol name /*, Type t*/);
+    const Variable& createSymbolVar(Symbol name, int address /*, Type t*/);
+    const Variable& getSymbolVar(Symbol name);
     const Variable& createTmpVar(/*Type t*/);
+    inline const std::vector<const Variable*>& getVariables() const { return _variables; } // indexed by Variable::id
 
     BasicBlock& getCurrentBlock() const;
     
     inline int resetMemoryCount() {
         int count = _memorySize;
-        _memorySize = 0; _tmpCount = 0;
+        _memorySize = 0;
         return count;
     }
 protected:
     int reserveSpace(int size);
+    Variable* createVariable(Symbol name, int offset);
     
-    std::vector<std::shared_ptr<Variable>> _symbols;
+    const Options& _options;
+    Arena _arena; // the blocks, their instructions and the variables, freed with the graph
     int _memorySize; // to allocate new symbols in the symbol table
-    std::vector<std::map<std::string, Variable*>> _contextSymbolMaps; // part of the symbol table
-    std::vector<std::map<std::string, Variable*>> _contextTmpMaps; // part of the temporary symbol table
-    int _tmpCount; // just for naming
+    ScopedSymbolTable<Variable*> _symbols; // the variables of the open contexts, the temporaries have no name
+    std::vector<const Variable*> _variables; // all the variables of the graph, by id
+    int _stringCount; // just for naming
+    int _blockCount; // just for naming, the labels are unique in the output of a translation unit
+    int _firstBlockNumber;
+    int _firstStringNumber;
 
-    std::vector<std::unique_ptr<BasicBlock>> _blocks; // all the basic blocks of this CF
+    std::vector<BasicBlock*> _blocks; // all the basic blocks of this CF
     BasicBlock* _currentBB;
 };
 
@@ -0,0 +1,346 @@
+#include <unordered_map>
+#include "DenseIR.h"
+#include "ControlFlowGraph.h"
+#include "Runtime.h"
+
+using namespace IR;
+
+std::string extractFunctionName(const std::string& s); // Block.cpp
+
+DenseGraph::DenseGraph(const ControlFlowGraph& cfg) : _cfg(cfg), _bufferedIO(cfg.getOptions().bufferedIO)
+{
+    // the names of the functions and the registers are shared, the labels and the texts are unique
+    std::unordered_map<std::string, uint32_t> nameIndex;
+    auto name = [&](const std::string& s) {
+        auto inserted = nameIndex.emplace(s, (uint32_t)_strings.size());
+        if (inserted.second) _strings.push_back(s);
+        return inserted.first->second;
+    };
+    auto string = [&](const std::string& s) {
+        _strings.push_back(s);
+        return (uint32_t)_strings.size() - 1;
+    };
+
+    _offsets.reserve(cfg.getVariables().size());
+    for (const Variable* v : cfg.getVariables()) _offsets.push_back(v->offset);
+
+    // the labels of all the blocks first, for the jumps
+    std::unordered_map<const BasicBlock*, uint32_t> labels;
+    for (const BasicBlock* block : cfg.getBlocks()) labels.emplace(block, string(block->getLabel()));
+    auto label = [&](const BasicBlock& target) {
+        auto found = labels.find(&target);
+        return found != labels.end() ? found->second : string(target.getLabel());
+    };
+
+    _blocks.reserve(cfg.getBlocks().size());
+    for (const BasicBlock* block : cfg.getBlocks()) {
+        Block dense;
+        uint32_t blockLabel = labels[block];
+        std::string defined = extractFunctionName(_strings[blockLabel]);
+        dense.name = defined.size() == _strings[blockLabel].size() ? blockLabel : string(defined);
+        dense.first = (uint32_t)_instructions.size();
+        for (const Instruction* inst : block->getInstructions()) {
+            DenseInstruction d = { inst->getOpcode(), 0, 0 };
+            switch (d.opcode) {
+            case Opcode::GenFunc: {
+                auto genFunc = static_cast<const GenFunc*>(inst);
+                Function function = { name(genFunc->getName()), genFunc->stackSize, (uint32_t)_parameters.size(), (uint32_t)genFunc->getVarList().size() };
+                for (const auto& parameter : genFunc->getVarList()) _parameters.push_back(parameter.id);
+                d.a = (uint32_t)_functions.size();
+                _functions.push_back(function);
+                break;
+            }
+            case Opcode::CallFunc: {
+                auto callFunc = static_cast<const CallFunc*>(inst);
+                d.a = name(callFunc->getName());
+                d.b = (uint32_t)callFunc->getVarList().size();
+                break;
+            }
+            case Opcode::MovToReg: {
+                auto movToReg = static_cast<const MovToReg*>(inst);
+                d.a = movToReg->getVar().id;
+                d.b = name(movToReg->getRegister());
+                break;
+            }
+            case Opcode::LdConst:
+                d.a = (uint32_t)static_cast<const LdConst*>(inst)->getValue();
+                break;
+            case Opcode::LdLoc:
+                d.a = static_cast<const LdLoc*>(inst)->getLoc().id;
+                break;
+            case Opcode::Store:
+                d.a = static_cast<const Store*>(inst)->getLoc().id;
+                break;
+            case Opcode::Add: d.a = static_cast<const Add*>(inst)->getLhs().id; break;
+            case Opcode::Sub: d.a = static_cast<const Sub*>(inst)->getLhs().id; break;
+            case Opcode::Mul: d.a = static_cast<const Mul*>(inst)->getLhs().id; break;
+            case Opcode::Div: d.a = static_cast<const Div*>(inst)->getLhs().id; break;
+            case Opcode::Mod: d.a = static_cast<const Mod*>(inst)->getLhs().id; break;
+            case Opcode::BitAnd: d.a = static_cast<const BitAnd*>(inst)->getLhs().id; break;
+            case Opcode::BitXor: d.a = static_cast<const BitXor*>(inst)->getLhs().id; break;
+            case Opcode::BitOr: d.a = static_cast<const BitOr*>(inst)->getLhs().id; break;
+            case Opcode::CompGt: d.a = static_cast<const CompGt*>(inst)->getLhs().id; break;
+            case Opcode::CompLt: d.a = static_cast<const CompLt*>(inst)->getLhs().id; break;
+            case Opcode::CompGtEq: d.a = static_cast<const CompGtEq*>(inst)->getLhs().id; break;
+            case Opcode::CompLtEq: d.a = static_cast<const CompLtEq*>(inst)->getLhs().id; break;
+            case Opcode::CompEq: d.a = static_cast<const CompEq*>(inst)->getLhs().id; break;
+            case Opcode::CompNe: d.a = static_cast<const CompNe*>(inst)->getLhs().id; break;
+            case Opcode::BrTrue:
+                d.a = label(static_cast<const BrTrue*>(inst)->getTarget());
+                break;
+            case Opcode::Br:
+                d.a = label(static_cast<const Br*>(inst)->getTarget());
+                break;
+            case Opcode::PutString: {
+                auto putString = static_cast<const PutString*>(inst);
+                d.a = string(putString->getText());
+                d.b = (uint32_t)putString->getNumber();
+                break;
+            }
+            case Opcode::ProfileEnter:
+                d.a = name(static_cast<const ProfileEnter*>(inst)->getName());
+                break;
+            case Opcode::ProfileExit:
+                d.a = name(static_cast<const ProfileExit*>(inst)->getName());
+                break;
+            case Opcode::PushQ:
+            case Opcode::Negate:
+            case Opcode::LogicalNot:
+            case Opcode::CastBool:
+            case Opcode::Return:
+                break;
+            }
+            _instructions.push_back(d);
+        }
+        dense.end = (uint32_t)_instructions.size();
+        dense.exitTrue = block->getExitTrue() ? label(*block->getExitTrue()) : NONE;
+        dense.exitFalse = block->getExitFalse() ? label(*block->getExitFalse()) : NONE;
+        _blocks.push_back(dense);
+    }
+}
+
+// Each case writes the same assembly as the generateAsm of its instruction in Instruction.cpp
+void DenseGraph::generateAsm(AsmBuffer& o) const
+{
+    static const std::string_view parameterRegisters[] = { "%edi", "%esi", "%edx", "%ecx", "%r8d", "%r9d" };
+
+    auto variable = [&](AsmBuffer& text, uint32_t id) { text << _offsets[id] << "(%rbp)"; };
+    for (const Block& block : _blocks) {
+        const std::string& name = _strings[block.name];
+        o << ".globl " << name << "\n";
+        o << name << ":" << "\n";
+
+        for (uint32_t i = block.first; i < block.end; ++i) {
+            const DenseInstruction& d = _instructions[i];
+            const char* setcc = nullptr;
+            switch (d.opcode) {
+            case Opcode::GenFunc: {
+                const Function& function = _functions[d.a];
+                o << "\t# prologue:\n";
+                o << "\tpushq\t%rbp # save %rbp on the stack\n";
+                o << "\tmovq\t%rsp, %rbp # define %rbp for the current function\n\n";
+                o << "\tsubq\t$" << ((function.stackSize + 15) / 16) * 16 << ", %rsp # move the stack pointer\n\n";
+                if (_strings[function.name] == "main") break;
+                for (uint32_t j = 0; j < function.parameterCount && j < 6; ++j) {
+                    o << "\tmovl\t" << parameterRegisters[j] << ", ";
+                    variable(o, _parameters[function.firstParameter + j]);
+                    o << "\n";
+                }
+                break;
+            }
+            case Opcode::CallFunc: {
+                const std::string& function = _strings[d.a];
+                if (_bufferedIO && function == "putchar") {
+                    o << "\tmovl\t__ifcc_outpos(%rip), %eax\n";
+                    o << "\tcmpl\t$" << IO_BUFFER_SIZE << ", %eax\n";
+                    o << "\tjae\t1f\n";
+                    o << "\tleaq\t__ifcc_outbuf(%rip), %rdx\n";
+                    o << "\tmovb\t%dil, (%rdx,%rax)\n";
+                    o << "\taddl\t$1, %eax\n";
+                    o << "\tmovl\t%eax, __ifcc_outpos(%rip)\n";
+                    o << "\tmovzbl\t%dil, %eax\n";
+                    o << "\tjmp\t2f\n";
+                    o << "1:\n";
+                    o << "\tcall\t__ifcc_putchar\n";
+                    o << "2:\n";
+                    break;
+                }
+                if (_bufferedIO && function == "getchar") {
+                    o << "\tcall\t__ifcc_getchar\n";
+                    break;
+                }
+                o << "\tcall\t" << function << "\n";
+                if (d.b > 6) o << "\taddq\t$" << (d.b - 6) * 8 << ", %rsp\n";
+                break;
+            }
+            case Opcode::MovToReg:
+                o << "\tmovl\t";
+                variable(o, d.a);
+                o << ", " << _strings[d.b] << "\n";
+                break;
+            case Opcode::PushQ:
+                o << "\tpushq\t%rdi\n";
+                break;
+            case Opcode::LdConst:
+                o << "\tmovl\t$" << (int32_t)d.a << ", %eax\n";
+                break;
+            case Opcode::LdLoc:
+                o << "\tmovl\t";
+                variable(o, d.a);
+                o << ", %eax\n";
+                break;
+            case Opcode::Store:
+                o << "\tmovl\t%eax, ";
+                variable(o, d.a);
+                o << "\n";
+                break;
+            case Opcode::Add:
+                o << "\taddl\t";
+                variable(o, d.a);
+                o << ",%eax\n";
+                break;
+            case Opcode::Sub:
+                o << "\tsubl\t%eax,";
+                variable(o, d.a);
+                o << "\n\tmovl\t";
+                variable(o, d.a);
+                o << ", %eax\n";
+                break;
+            case Opcode::Mul:
+                o << "\timull\t";
+                variable(o, d.a);
+                o << ",%eax\n";
+                break;
+            case Opcode::Div:
+            case Opcode::Mod:
+                o << "\tmovl\t%eax, %ebx\n";
+                o << "\tmovl\t";
+                variable(o, d.a);
+                o << ", %eax\n";
+                o << "\tcltd\n";
+                o << "\tidivl\t%ebx\n";
+                if (d.opcode == Opcode::Mod) o << "\tmovl\t%edx, %eax\n";
+                break;
+            case Opcode::Negate:
+                o << "\tnegl\t%eax\n";
+                break;
+            case Opcode::LogicalNot:
+                o << "\tcmpl\t$0, %eax\n";
+                o << "\tsete\t%al\n";
+                o << "\tandb\t$1, %al\n";
+                o << "\tmovzbl\t%al, %eax\n";
+                break;
+            case Opcode::BitAnd:
+                o << "\tandl\t";
+                variable(o, d.a);
+                o << ",%eax\n";
+                break;
+            case Opcode::BitXor:
+                o << "\txorl\t";
+                variable(o, d.a);
+                o << ",%eax\n";
+                break;
+            case Opcode::BitOr:
+                o << "\torl\t";
+                variable(o, d.a);
+                o << ",%eax\n";
+                break;
+            case Opcode::CompGt: setcc = "setg"; break;
+            case Opcode::CompLt: setcc = "setl"; break;
+            case Opcode::CompGtEq: setcc = "setge"; break;
+            case Opcode::CompLtEq: setcc = "setle"; break;
+            case Opcode::CompEq: setcc = "sete"; break;
+            case Opcode::CompNe: setcc = "setne"; break;
+            case Opcode::CastBool:
+                o << "\tcmpl\t$0, %eax\n";
+                o << "\tsetne\t%al\n";
+                o << "\tandl\t$1, %eax\n";
+                break;
+            case Opcode::BrTrue:
+                o << "\tcmpl\t$0, %eax\n";
+                o << "\tjne\t" << _strings[d.a] << "\n";
+                break;
+            case Opcode::Br:
+                o << "\tjmp\t" << _strings[d.a] << "\n";
+                break;
+            case Opcode::Return:
+                o << "\tmovq\t%rbp, %rsp # moves %rbp from the stack\n";
+                o << "\tpopq\t%rbp # restore %rbp from the stack\n";
+                o << "\tret # return to the caller (here the shell)\n";
+                break;
+            case Opcode::PutString: {
+                const std::string& text = _strings[d.a];
+                std::string label = _cfg.getStringLabel((int)d.b);
+                o << "\t.pushsection .rodata\n";
+                o << label << ":\n";
+                o << "\t.ascii\t\"";
+                for (unsigned char c : text) {
+                    if (c == '"' || c == '\\') o << '\\' << c;
+                    else if (c >= ' ' && c <= '~') o << c;
+                    else o << '\\' << (char)('0' + (c >> 6)) << (char)('0' + ((c >> 3) & 7)) << (char)('0' + (c & 7));
+                }
+                o << "\"\n";
+                o << "\t.popsection\n";
+                o << "\tleaq\t" << label << "(%rip), %rdi\n";
+                if (_bufferedIO) {
+                    o << "\tmovl\t$" << text.size() << ", %esi\n";
+                    o << "\tcall\t__ifcc_write\n";
+                }
+                else {
+                    o << "\tmovl\t$1, %esi\n";
+                    o << "\tmovl\t$" << text.size() << ", %edx\n";
+                    o << "\tmovq\tstdout@GOTPCREL(%rip), %rcx\n";
+                    o << "\tmovq\t(%rcx), %rcx\n";
+                    o << "\tcall\tfwrite\n";
+                }
+                o << "\tmovl\t$" << (int)(unsigned char)text.back() << ", %eax\n";
+                break;
+            }
+            case Opcode::ProfileEnter: {
+                const std::string& function = _strings[d.a];
+                o << "\t.pushsection .rodata\n";
+                o << ".Lprof_name_" << function << ":\n";
+                o << "\t.string \"" << function << "\"\n";
+                o << "\t.section .data\n";
+                o << "\t.balign 8\n";
+                o << ".Lprof_" << function << ":\n";
+                o << "\t.quad\t.Lprof_name_" << function << "\n";
+                o << "\t.zero\t40\n";
+                o << "\t.popsection\n";
+                o << "\tpushq\t%rax\n";
+                o << "\tsubq\t$8, %rsp\n";
+                o << "\trdtsc\n";
+                o << "\tshlq\t$32, %rdx\n";
+                o << "\torq\t%rdx, %rax\n";
+                o << "\tmovq\t%rax, %rsi\n";
+                o << "\tleaq\t.Lprof_" << function << "(%rip), %rdi\n";
+                o << "\tcall\t__ifcc_prof_enter\n";
+                o << "\taddq\t$8, %rsp\n";
+                o << "\tpopq\t%rax\n";
+                break;
+            }
+            case Opcode::ProfileExit:
+                o << "\tpushq\t%rax\n";
+                o << "\tsubq\t$8, %rsp\n";
+                o << "\trdtsc\n";
+                o << "\tshlq\t$32, %rdx\n";
+                o << "\torq\t%rdx, %rax\n";
+                o << "\tmovq\t%rax, %rsi\n";
+                o << "\tleaq\t.Lprof_" << _strings[d.a] << "(%rip), %rdi\n";
+                o << "\tcall\t__ifcc_prof_exit\n";
+                o << "\taddq\t$8, %rsp\n";
+                o << "\tpopq\t%rax\n";
+                break;
+            }
+            if (setcc) {
+                o << "\tcmpl\t%eax, ";
+                variable(o, d.a);
+                o << "\n\t" << setcc << "\t%al\n";
+                o << "\tandb\t$1, %al\n";
+                o << "\tmovzbl\t%al, %eax\n";
+            }
+        }
+        if (block.exitTrue != NONE) o << "\tcmpl\t$0, %eax\n\tjne\t" << _strings[block.exitTrue] << "\n";
+        if (block.exitFalse != NONE) o << "\tjmp\t" << _strings[block.exitFalse] << "\n";
+    }
+}
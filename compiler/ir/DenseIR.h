@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Instruction.h"
+#include "AsmBuffer.h"
+
+namespace IR {
+
+class ControlFlowGraph;
+
+// An instruction of the dense IR: its opcode and two operands whose meaning depends on the opcode (see DenseGraph)
+struct DenseInstruction {
+    Opcode opcode;
+    uint32_t a;
+    uint32_t b;
+};
+
+/*
+    Dense form of an optimized ControlFlowGraph, used for the assembly generation (--ir=dense, the default).
+    The instructions of all the blocks are stored one after the other in a single array, a block being a range
+    of this array, and the operands are 32-bit indices instead of references to objects spread in the arena:
+    - a: the variable (Variable::id, its offset is in the side table _offsets) for LdLoc, Store, MovToReg and the
+      binary operations, the value for LdConst, the index of the target label in _strings for Br and BrTrue,
+      the index of the function in _functions for GenFunc, the index of the name in _strings for CallFunc,
+      ProfileEnter and ProfileExit, the index of the text in _strings for PutString
+    - b: the register (index of its name in _strings) for MovToReg, the number of arguments for CallFunc,
+      the number of the string in the graph for PutString (see ControlFlowGraph::getStringLabel)
+    The assembly is generated by a switch on the opcodes instead of a virtual call per instruction, directly in
+    the output buffer, and is the same as the one of BasicBlock::generateAsm.
+*/
+class DenseGraph {
+public:
+    explicit DenseGraph(const ControlFlowGraph& cfg);
+
+    void generateAsm(AsmBuffer& o) const; // same as the generateAsm of the blocks
+    inline size_t getInstructionCount() const { return _instructions.size(); }
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct Block {
+        uint32_t name; // index in _strings of the name defined by the block (the label without the parameters)
+        uint32_t first; // its instructions are [first, end) in _instructions
+        uint32_t end;
+        uint32_t exitTrue; // index of the label in _strings, NONE if no exit
+        uint32_t exitFalse;
+    };
+    struct Function {
+        uint32_t name; // index in _strings
+        int stackSize;
+        uint32_t firstParameter; // the variables of the parameters are [firstParameter, firstParameter + parameterCount) in _parameters
+        uint32_t parameterCount;
+    };
+
+    std::vector<DenseInstruction> _instructions;
+    std::vector<Block> _blocks;
+    std::vector<Function> _functions;
+    std::vector<uint32_t> _parameters;
+    std::vector<int32_t> _offsets; // offset from %rbp of each variable, by id
+    std::vector<std::string> _strings; // names, labels, registers and texts
+    const ControlFlowGraph& _cfg; // labels of the strings
+    bool _bufferedIO;
+};
+
+}
@@ -2,6 +2,7 @@
 #include "Block.h"
 
 #include "ControlFlowGraph.h"
+#include "Runtime.h"
 
 using namespace IR;
 
@@ -41,9 +42,11 @@ void GenFunc::generateAsm(std::ostream& o) const
         o << "\tmovl\t" << registre[i] << ", " << varToAsm(varList[i]) << "\n";
 }
 
+MovToReg::MovToReg(BasicBlock& block, const Variable& var, const std::string reg) : Instruction(block, Opcode::MovToReg), var(var), reg(reg) {}
+
 void MovToReg::generateAsm(std::ostream& o) const
 {
-    o << "\tmovl\t" << name1 << ", " << name2 << "\n";
+    o << "\tmovl\t" << varToAsm(var) << ", " << reg << "\n";
 }
 
 void PushQ::generateAsm(std::ostream& o) const
@@ -53,6 +56,28 @@ void PushQ::generateAsm(std::ostream& o) const
 
 void CallFunc::generateAsm(std::ostream& o) const
 {
+    if (block.getCFG().getOptions().bufferedIO) {
+        if (name == "putchar") {
+            // fast path: the character (in %edi) is stored in the buffer without a call
+            o << "\tmovl\t__ifcc_outpos(%rip), %eax\n";
+            o << "\tcmpl\t$" << IO_BUFFER_SIZE << ", %eax\n";
+            o << "\tjae\t1f\n";
+            o << "\tleaq\t__ifcc_outbuf(%rip), %rdx\n";
+            o << "\tmovb\t%dil, (%rdx,%rax)\n";
+            o << "\taddl\t$1, %eax\n";
+            o << "\tmovl\t%eax, __ifcc_outpos(%rip)\n";
+            o << "\tmovzbl\t%dil, %eax\n";
+            o << "\tjmp\t2f\n";
+            o << "1:\n";
+            o << "\tcall\t__ifcc_putchar\n";
+            o << "2:\n";
+            return;
+        }
+        if (name == "getchar") {
+            o << "\tcall\t__ifcc_getchar\n";
+            return;
+        }
+    }
     o << "\tcall\t" << name << "\n";
     if (!varList.empty() && varList.size() > 6)
         o << "\taddq\t$" << (varList.size() - 6) * 8 << ", %rsp\n";
@@ -175,7 +200,7 @@ void Return::generateAsm(std::ostream& o) const
 {
     o << "\tmovq\t%rbp, %rsp # moves %rbp from the stack\n";
     o << "\tpopq\t%rbp # restore %rbp from the stack\n";
-    o << "\tret # return to the caller (here the shell)" << std::endl;
+    o << "\tret # return to the caller (here the shell)\n";
 }
 
 void IR::Br::generateAsm(std::ostream& o) const
@@ -195,3 +220,80 @@ void IR::CastBool::generateAsm(std::ostream& o) const
     o << "\tsetne\t" << regByte() << "\n";
     o << "\tandl\t$1, " << reg() << "\n";
 }
+
+std::string PutString::getLabel() const
+{
+    return block.getCFG().getStringLabel(number);
+}
+
+void PutString::generateAsm(std::ostream& o) const
+{
+    std::string label = getLabel();
+    o << "\t.pushsection .rodata\n";
+    o << label << ":\n";
+    o << "\t.ascii\t\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') o << '\\' << c;
+        else if (c >= ' ' && c <= '~') o << c;
+        else o << '\\' << (char)('0' + (c >> 6)) << (char)('0' + ((c >> 3) & 7)) << (char)('0' + (c & 7));
+    }
+    o << "\"\n";
+    o << "\t.popsection\n";
+
+    o << "\tleaq\t" << label << "(%rip), %rdi\n";
+    if (block.getCFG().getOptions().bufferedIO) {
+        // same buffer as the inlined putchar calls
+        o << "\tmovl\t$" << text.size() << ", %esi\n";
+        o << "\tcall\t__ifcc_write\n";
+    }
+    else {
+        // same FILE as putchar, so the order of the outputs is kept
+        o << "\tmovl\t$1, %esi\n";
+        o << "\tmovl\t$" << text.size() << ", %edx\n";
+        o << "\tmovq\tstdout@GOTPCREL(%rip), %rcx\n";
+        o << "\tmovq\t(%rcx), %rcx\n";
+        o << "\tcall\tfwrite\n";
+    }
+    o << "\tmovl\t$" << (int)(unsigned char)text.back() << ", " << reg() << "\n";
+}
+
+void ProfileEnter::generateAsm(std::ostream& o) const
+{
+    // record layout: name, calls, inclusive cycles, exclusive cycles, active calls, next record
+    o << "\t.pushsection .rodata\n";
+    o << ".Lprof_name_" << name << ":\n";
+    o << "\t.string \"" << name << "\"\n";
+    o << "\t.section .data\n";
+    o << "\t.balign 8\n";
+    o << ".Lprof_" << name << ":\n";
+    o << "\t.quad\t.Lprof_name_" << name << "\n";
+    o << "\t.zero\t40\n";
+    o << "\t.popsection\n";
+
+    // %rax is kept like in ProfileExit, the instrumentation does not change even an unset return value
+    o << "\tpushq\t%rax\n";
+    o << "\tsubq\t$8, %rsp\n";
+    o << "\trdtsc\n";
+    o << "\tshlq\t$32, %rdx\n";
+    o << "\torq\t%rdx, %rax\n";
+    o << "\tmovq\t%rax, %rsi\n";
+    o << "\tleaq\t.Lprof_" << name << "(%rip), %rdi\n";
+    o << "\tcall\t__ifcc_prof_enter\n";
+    o << "\taddq\t$8, %rsp\n";
+    o << "\tpopq\t%rax\n";
+}
+
+void ProfileExit::generateAsm(std::ostream& o) const
+{
+    // the return value is kept on the stack, two slots keep %rsp aligned for the call
+    o << "\tpushq\t%rax\n";
+    o << "\tsubq\t$8, %rsp\n";
+    o << "\trdtsc\n";
+    o << "\tshlq\t$32, %rdx\n";
+    o << "\torq\t%rdx, %rax\n";
+    o << "\tmovq\t%rax, %rsi\n";
+    o << "\tleaq\t.Lprof_" << name << "(%rip), %rdi\n";
+    o << "\tcall\t__ifcc_prof_exit\n";
+    o << "\taddq\t$8, %rsp\n";
+    o << "\tpopq\t%rax\n";
+}
@@ -1,38 +1,59 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <iostream>
+#include "Variable.h"
+#include "../x86/Encoder.h"
 
 namespace IR {
 
 class BasicBlock;
-struct Variable;
+class Interpreter;
+
+// Kind of an instruction: the passes test it instead of using dynamic_cast, and it is the opcode of the dense IR (see DenseIR.h)
+enum class Opcode : uint8_t {
+    GenFunc, CallFunc, MovToReg, PushQ, LdConst, LdLoc, Store, Add, Sub, Mul, Div, Mod, Negate, LogicalNot,
+    BitAnd, BitXor, BitOr, CompGt, CompLt, CompGtEq, CompLtEq, CompEq, CompNe, CastBool, BrTrue, Br, Return,
+    PutString, ProfileEnter, ProfileExit
+};
 
 class Instruction {
 
 public:
+    inline Opcode getOpcode() const { return opcode; }
+
     //  Actual code generation
     virtual void generateAsm(std::ostream& o) const = 0;
+    virtual void generateCode(x86::Encoder& e) const = 0; // machine code, see MachineCode.cpp
+    virtual void execute(Interpreter& m) const = 0; // --interp, see Interpreter.cpp
 
     std::string varToAsm(const Variable& variable) const;
+    x86::Mem varToMem(const Variable& variable) const;
 
     virtual ~Instruction() {}
 
 protected:
     //   constructor
-    Instruction(BasicBlock& block /*, Type t*/) : block(block) {}
+    Instruction(BasicBlock& block, Opcode opcode /*, Type t*/) : opcode(opcode), block(block) {}
 
     // variables
+    const Opcode opcode;
     BasicBlock& block; // The BB this instruction belongs to, which provides a pointer to the CFG this instruction belongs to
     // Type t;
 };
 
 class GenFunc : public Instruction {
 public:
-    GenFunc(BasicBlock& block, const std::string str) : Instruction(block), name(str) {}
-    GenFunc(BasicBlock& block, const std::string str, const std::vector<Variable>& loc) : Instruction(block), name(str), varList(loc) {}
+    GenFunc(BasicBlock& block, const std::string str) : Instruction(block, Opcode::GenFunc), name(str) {}
+    GenFunc(BasicBlock& block, const std::string str, const std::vector<Variable>& loc) : Instruction(block, Opcode::GenFunc), name(str), varList(loc) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const std::string& getName() const { return name; }
+    inline const std::vector<Variable>& getVarList() const { return varList; }
 
     int stackSize;
 private:
@@ -42,8 +63,13 @@ private:
 
 class CallFunc : public Instruction {
 public:
-    CallFunc(BasicBlock& block, const std::string str, const std::vector<Variable>& vars) : Instruction(block), name(str), varList(vars) {}
+    CallFunc(BasicBlock& block, const std::string str, const std::vector<Variable>& vars) : Instruction(block, Opcode::CallFunc), name(str), varList(vars) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const std::string& getName() const { return name; }
+    inline const std::vector<Variable>& getVarList() const { return varList; }
 
 private:
     std::string name;
@@ -52,25 +78,35 @@ private:
 
 class MovToReg : public Instruction {
 public:
-    MovToReg(BasicBlock& block, const std::string var, const std::string reg) : Instruction(block), name1(var), name2(reg) {}
-    MovToReg(BasicBlock& block, const Variable& var, const std::string reg) : Instruction(block), name2(reg) { name1 = varToAsm(var); }
+    MovToReg(BasicBlock& block, const Variable& var, const std::string reg);
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const Variable& getVar() const { return var; }
+    inline const std::string& getRegister() const { return reg; }
 
 private:
-    std::string name1;
-    std::string name2;
+    Variable var;
+    std::string reg;
 };
 
 class PushQ : public Instruction {
 public:
-    PushQ(BasicBlock& block) : Instruction(block) {}
+    PushQ(BasicBlock& block) : Instruction(block, Opcode::PushQ) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
 };
 
 class LdConst : public Instruction {
 public:
-    LdConst(BasicBlock& block, int constValue) : Instruction(block), value(constValue) {}
+    LdConst(BasicBlock& block, int constValue) : Instruction(block, Opcode::LdConst), value(constValue) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline int getValue() const { return value; }
 
 private:
     int value;
@@ -78,8 +114,12 @@ private:
 
 class LdLoc : public Instruction {
 public:
-    LdLoc(BasicBlock& block, const Variable& loc) : Instruction(block), loc(loc) {}
+    LdLoc(BasicBlock& block, const Variable& loc) : Instruction(block, Opcode::LdLoc), loc(loc) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const Variable& getLoc() const { return loc; }
 
 private:
     const Variable& loc;
@@ -87,8 +127,12 @@ private:
 
 class Store : public Instruction {
 public:
-    Store(BasicBlock& block, const Variable& loc) : Instruction(block), loc(loc) {}
+    Store(BasicBlock& block, const Variable& loc) : Instruction(block, Opcode::Store), loc(loc) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const Variable& getLoc() const { return loc; }
 
 private:
     const Variable& loc;
@@ -96,8 +140,12 @@ private:
 
 class Add : public Instruction {
 public:
-    Add(BasicBlock& block, const Variable& lhs) : Instruction(block), lhs(lhs) {}
+    Add(BasicBlock& block, const Variable& lhs) : Instruction(block, Opcode::Add), lhs(lhs) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const Variable& getLhs() const { return lhs; }
 
 private:
     const Variable& lhs;
@@ -105,8 +153,12 @@ private:
 
 class Sub : public Instruction {
 public:
-    Sub(BasicBlock& block, const Variable& lhs) : Instruction(block), lhs(lhs) {}
+    Sub(BasicBlock& block, const Variable& lhs) : Instruction(block, Opcode::Sub), lhs(lhs) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const Variable& getLhs() const { return lhs; }
 
 private:
     const Variable& lhs;
@@ -115,8 +167,12 @@ private:
 
 class Mul : public Instruction {
 public:
-    Mul(BasicBlock& block, const Variable& lhs) : Instruction(block), lhs(lhs) {}
+    Mul(BasicBlock& block, const Variable& lhs) : Instruction(block, Opcode::Mul), lhs(lhs) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const Variable& getLhs() const { return lhs; }
 
 private:
     const Variable& lhs;
@@ -124,8 +180,12 @@ private:
 
 class Div : public Instruction {
 public:
-    Div(BasicBlock& block, const Variable& lhs) : Instruction(block), lhs(lhs) {}
+    Div(BasicBlock& block, const Variable& lhs) : Instruction(block, Opcode::Div), lhs(lhs) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const Variable& getLhs() const { return lhs; }
 
 private:
     const Variable& lhs;
@@ -133,8 +193,12 @@ private:
 
 class Mod : public Instruction {
 public:
-    Mod(BasicBlock& block, const Variable& lhs) : Instruction(block), lhs(lhs) {}
+    Mod(BasicBlock& block, const Variable& lhs) : Instruction(block, Opcode::Mod), lhs(lhs) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const Variable& getLhs() const { return lhs; }
 
 private:
     const Variable& lhs;
@@ -142,20 +206,28 @@ private:
 
 class Negate : public Instruction {
 public:
-    Negate(BasicBlock& block) : Instruction(block) {}
+    Negate(BasicBlock& block) : Instruction(block, Opcode::Negate) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
 };
 
 class LogicalNot : public Instruction {
 public:
-    LogicalNot(BasicBlock& block) : Instruction(block) {}
+    LogicalNot(BasicBlock& block) : Instruction(block, Opcode::LogicalNot) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
 };
 
 class BitAnd : public Instruction {
 public:
-    BitAnd(BasicBlock& block, const Variable& lhs) : Instruction(block), lhs(lhs) {}
+    BitAnd(BasicBlock& block, const Variable& lhs) : Instruction(block, Opcode::BitAnd), lhs(lhs) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const Variable& getLhs() const { return lhs; }
 
 private:
     const Variable& lhs;
@@ -163,8 +235,12 @@ private:
 
 class BitXor : public Instruction {
 public:
-    BitXor(BasicBlock& block, const Variable& lhs) : Instruction(block), lhs(lhs) {}
+    BitXor(BasicBlock& block, const Variable& lhs) : Instruction(block, Opcode::BitXor), lhs(lhs) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const Variable& getLhs() const { return lhs; }
 
 private:
     const Variable& lhs;
@@ -172,8 +248,12 @@ private:
 
 class BitOr : public Instruction {
 public:
-    BitOr(BasicBlock& block, const Variable& lhs) : Instruction(block), lhs(lhs) {}
+    BitOr(BasicBlock& block, const Variable& lhs) : Instruction(block, Opcode::BitOr), lhs(lhs) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const Variable& getLhs() const { return lhs; }
 
 private:
     const Variable& lhs;
@@ -181,8 +261,12 @@ private:
 
 class CompGt : public Instruction {
 public:
-    CompGt(BasicBlock& block, const Variable& lhs) : Instruction(block), lhs(lhs) {}
+    CompGt(BasicBlock& block, const Variable& lhs) : Instruction(block, Opcode::CompGt), lhs(lhs) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const Variable& getLhs() const { return lhs; }
 
 private:
     const Variable& lhs;
@@ -190,8 +274,12 @@ private:
 
 class CompLt : public Instruction {
 public:
-    CompLt(BasicBlock& block, const Variable& lhs) : Instruction(block), lhs(lhs) {}
+    CompLt(BasicBlock& block, const Variable& lhs) : Instruction(block, Opcode::CompLt), lhs(lhs) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const Variable& getLhs() const { return lhs; }
 
 private:
     const Variable& lhs;
@@ -199,8 +287,12 @@ private:
 
 class CompGtEq : public Instruction {
 public:
-    CompGtEq(BasicBlock& block, const Variable& lhs) : Instruction(block), lhs(lhs) {}
+    CompGtEq(BasicBlock& block, const Variable& lhs) : Instruction(block, Opcode::CompGtEq), lhs(lhs) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const Variable& getLhs() const { return lhs; }
 
 private:
     const Variable& lhs;
@@ -208,8 +300,12 @@ private:
 
 class CompLtEq : public Instruction {
 public:
-    CompLtEq(BasicBlock& block, const Variable& lhs) : Instruction(block), lhs(lhs) {}
+    CompLtEq(BasicBlock& block, const Variable& lhs) : Instruction(block, Opcode::CompLtEq), lhs(lhs) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const Variable& getLhs() const { return lhs; }
 
 private:
     const Variable& lhs;
@@ -217,8 +313,12 @@ private:
 
 class CompEq : public Instruction {
 public:
-    CompEq(BasicBlock& block, const Variable& lhs) : Instruction(block), lhs(lhs) {}
+    CompEq(BasicBlock& block, const Variable& lhs) : Instruction(block, Opcode::CompEq), lhs(lhs) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const Variable& getLhs() const { return lhs; }
 
 private:
     const Variable& lhs;
@@ -226,8 +326,12 @@ private:
 
 class CompNe : public Instruction {
 public:
-    CompNe(BasicBlock& block, const Variable& lhs) : Instruction(block), lhs(lhs) {}
+    CompNe(BasicBlock& block, const Variable& lhs) : Instruction(block, Opcode::CompNe), lhs(lhs) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const Variable& getLhs() const { return lhs; }
 
 private:
     const Variable& lhs;
@@ -235,14 +339,20 @@ private:
 
 class CastBool : public Instruction {
 public:
-    CastBool(BasicBlock& block) : Instruction(block) {}
+    CastBool(BasicBlock& block) : Instruction(block, Opcode::CastBool) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
 };
 
 class BrTrue : public Instruction {
 public:
-    BrTrue(BasicBlock& block, BasicBlock& target) : Instruction(block), target(target) {}
+    BrTrue(BasicBlock& block, BasicBlock& target) : Instruction(block, Opcode::BrTrue), target(target) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const BasicBlock& getTarget() const { return target; }
 
 private:
     BasicBlock& target;
@@ -250,15 +360,68 @@ private:
 
 class Br : public Instruction {
 public:
-    Br(BasicBlock& block, BasicBlock& target) : Instruction(block), target(target) {}
+    Br(BasicBlock& block, BasicBlock& target) : Instruction(block, Opcode::Br), target(target) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const BasicBlock& getTarget() const { return target; }
 private:
     BasicBlock& target;
 };
 
 class Return : public Instruction {
 public:
-    Return(BasicBlock& block) : Instruction(block) {}
+    Return(BasicBlock& block) : Instruction(block, Opcode::Return) {}
     void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+};
+
+// Writes a constant string on stdout, replaces a run of putchar calls with constant arguments (see BasicBlock::coalescePutchar)
+// %eax holds the value returned by the last putchar of the run
+class PutString : public Instruction {
+public:
+    PutString(BasicBlock& block, const std::string text, int number) : Instruction(block, Opcode::PutString), text(text), number(number) {}
+    void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const std::string& getText() const { return text; }
+    inline int getNumber() const { return number; }
+
+private:
+    std::string getLabel() const;
+
+    std::string text;
+    int number; // number of the string in its graph, see ControlFlowGraph::getStringLabel
+};
+
+// Profiling hooks (--profile): the profile record of the function is defined by ProfileEnter
+// The counters are updated by the runtime in runtime/ifcc_profile.c
+class ProfileEnter : public Instruction {
+public:
+    ProfileEnter(BasicBlock& block, const std::string str) : Instruction(block, Opcode::ProfileEnter), name(str) {}
+    void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const std::string& getName() const { return name; }
+
+private:
+    std::string name;
+};
+
+class ProfileExit : public Instruction {
+public:
+    ProfileExit(BasicBlock& block, const std::string str) : Instruction(block, Opcode::ProfileExit), name(str) {}
+    void generateAsm(std::ostream& o) const override;
+    void generateCode(x86::Encoder& e) const override;
+    void execute(Interpreter& m) const override;
+
+    inline const std::string& getName() const { return name; }
+
+private:
+    std::string name;
 };
 }
@@ -0,0 +1,282 @@
+#include <cstring>
+#include <climits>
+#include "Interpreter.h"
+#include "ControlFlowGraph.h"
+#include "Instruction.h"
+
+using namespace IR;
+
+static const size_t STACK_SIZE = 8 << 20; // same as the default stack limit of Linux
+
+Interpreter::Interpreter(const ControlFlowGraph& cfg, std::istream& in, std::ostream& out)
+    : Interpreter(std::vector<const ControlFlowGraph*>{ &cfg }, in, out) {}
+
+Interpreter::Interpreter(const std::vector<const ControlFlowGraph*>& program, std::istream& in, std::ostream& out)
+    : eax(0), _in(in), _out(out), _ioAllowed(true), _stack(STACK_SIZE), _rsp(STACK_SIZE), _rbp(STACK_SIZE),
+    _block(0), _instruction(0), _running(false), _steps(0), _maxSteps(0), _maxDepth(0),
+    _totalSteps(0), _maxTotalSteps(0)
+{
+    for (auto cfg : program) {
+        for (auto&& block : cfg->getBlocks()) {
+            _blockIndex[block] = _blocks.size();
+            const auto& instructions = block->getInstructions();
+            if (!instructions.empty() && instructions[0]->getOpcode() == Opcode::GenFunc)
+                _functions[static_cast<const GenFunc*>(instructions[0])->getName()] = _blocks.size();
+            _blocks.push_back(block);
+        }
+    }
+    memset(_registers, 0, sizeof(_registers));
+}
+
+void Interpreter::setLimits(uint64_t maxSteps, size_t maxDepth, uint64_t maxTotalSteps)
+{
+    _maxSteps = maxSteps;
+    _maxDepth = maxDepth;
+    _maxTotalSteps = maxTotalSteps;
+}
+
+bool Interpreter::run(const std::string& function, const std::vector<int>& args, int& result)
+{
+    static const x86::Reg registers[] = { x86::RDI, x86::RSI, x86::RDX, x86::RCX, x86::R8, x86::R9 };
+
+    _error.clear();
+    _running = true;
+    _steps = 0;
+    _callStack.clear();
+    _rsp = _rbp = _stack.size();
+
+    for (size_t i = 0; i < args.size() && i < 6; ++i) _registers[registers[i]] = args[i];
+    for (size_t i = args.size(); i > 6; --i) push((uint32_t)args[i - 1]);
+    if (!_functions.count(function)) {
+        fail("call to the undefined function " + function);
+        return false;
+    }
+    _block = _blocks.size();
+    call(function, args.size());
+
+    while (_running) {
+        const BasicBlock* block = _blocks[_block];
+        const auto& instructions = block->getInstructions();
+        if (_instruction < instructions.size()) {
+            if (_maxSteps && _steps >= _maxSteps) {
+                fail("step limit reached");
+                break;
+            }
+            if (_maxTotalSteps && _totalSteps >= _maxTotalSteps) {
+                fail("total step limit reached");
+                break;
+            }
+            ++_steps;
+            ++_totalSteps;
+            instructions[_instruction++]->execute(*this);
+        }
+        else if (block->getExitTrue() && eax != 0) jump(*block->getExitTrue());
+        else if (block->getExitFalse()) jump(*block->getExitFalse());
+        else if (_block + 1 < _blocks.size()) {
+            ++_block;
+            _instruction = 0;
+        }
+        else fail("the execution went past the last block");
+    }
+
+    result = eax;
+    return _error.empty();
+}
+
+// ---------------------------------------------------------------- machine state
+
+bool Interpreter::checkAddress(uint64_t address, size_t size)
+{
+    if (address <= _stack.size() && size <= _stack.size() - address) return true;
+    fail("invalid stack access");
+    return false;
+}
+
+int32_t Interpreter::load(const Variable& variable)
+{
+    uint64_t address = _rbp + variable.offset;
+    int32_t value = 0;
+    if (checkAddress(address, 4)) memcpy(&value, &_stack[address], 4);
+    return value;
+}
+
+void Interpreter::store(const Variable& variable, int32_t value)
+{
+    uint64_t address = _rbp + variable.offset;
+    if (checkAddress(address, 4)) memcpy(&_stack[address], &value, 4);
+}
+
+int32_t Interpreter::getRegister(const std::string& name) const
+{
+    return _registers[x86::regFromName(name)];
+}
+
+void Interpreter::setRegister(const std::string& name, int32_t value)
+{
+    _registers[x86::regFromName(name)] = value;
+}
+
+void Interpreter::push(uint64_t value)
+{
+    if (_rsp < 8) {
+        fail("stack overflow");
+        return;
+    }
+    _rsp -= 8;
+    memcpy(&_stack[_rsp], &value, 8);
+}
+
+uint64_t Interpreter::pop()
+{
+    uint64_t value = 0;
+    if (checkAddress(_rsp, 8)) memcpy(&value, &_stack[_rsp], 8);
+    _rsp += 8;
+    return value;
+}
+
+void Interpreter::enter(int stackSize)
+{
+    push(_rbp);
+    _rbp = _rsp;
+    uint64_t size = ((stackSize + 15) / 16) * 16;
+    if (_rsp < size) fail("stack overflow");
+    else _rsp -= size;
+}
+
+void Interpreter::call(const std::string& function, size_t argCount)
+{
+    if (function == "putchar" || function == "getchar") {
+        if (!_ioAllowed) {
+            fail("call to " + function);
+            return;
+        }
+        if (function == "putchar") {
+            _out.put((char)_registers[x86::RDI]);
+            eax = (unsigned char)_registers[x86::RDI];
+        }
+        else {
+            int c = _in.get();
+            eax = _in ? c : -1;
+        }
+        return;
+    }
+
+    auto it = _functions.find(function);
+    if (it == _functions.end()) {
+        fail("call to the undefined function " + function);
+        return;
+    }
+    if (_maxDepth && _callStack.size() >= _maxDepth) {
+        fail("recursion depth limit reached");
+        return;
+    }
+    push(0); // return address
+    _callStack.push_back({ _block, _instruction, argCount });
+    _block = it->second;
+    _instruction = 0;
+}
+
+void Interpreter::ret()
+{
+    _rsp = _rbp;
+    _rbp = pop();
+    pop(); // return address
+    Frame frame = _callStack.back();
+    _callStack.pop_back();
+    if (frame.argCount > 6) _rsp += (frame.argCount - 6) * 8;
+
+    if (frame.block == _blocks.size()) _running = false;
+    _block = frame.block;
+    _instruction = frame.instruction;
+}
+
+void Interpreter::jump(const BasicBlock& target)
+{
+    _block = _blockIndex[&target];
+    _instruction = 0;
+}
+
+void Interpreter::write(const std::string& text)
+{
+    if (!_ioAllowed) {
+        fail("call to putchar");
+        return;
+    }
+    _out.write(text.data(), text.size());
+}
+
+void Interpreter::fail(const std::string& error)
+{
+    if (_error.empty()) _error = error;
+    _running = false;
+}
+
+// ---------------------------------------------------------------- instructions
+
+static int32_t divide(Interpreter& m, int32_t lhs, int32_t rhs, bool remainder)
+{
+    // idivl raises SIGFPE in both cases
+    if (rhs == 0 || (lhs == INT_MIN && rhs == -1)) {
+        m.fail("division by zero");
+        return 0;
+    }
+    return remainder ? lhs % rhs : lhs / rhs;
+}
+
+void GenFunc::execute(Interpreter& m) const
+{
+    m.enter(stackSize);
+    if (!name.compare("main")) return;
+
+    std::vector<std::string> registre = { "%edi", "%esi", "%edx", "%ecx", "%r8d", "%r9d" };
+    for (int i = 0; i < varList.size() && i < 6; ++i)
+        m.store(varList[i], m.getRegister(registre[i]));
+}
+
+void MovToReg::execute(Interpreter& m) const { m.setRegister(reg, m.load(var)); }
+void PushQ::execute(Interpreter& m) const { m.push((uint32_t)m.getRegister("%edi")); }
+void CallFunc::execute(Interpreter& m) const { m.call(name, varList.size()); }
+void LdConst::execute(Interpreter& m) const { m.eax = value; }
+void LdLoc::execute(Interpreter& m) const { m.eax = m.load(loc); }
+void Store::execute(Interpreter& m) const { m.store(loc, m.eax); }
+void Add::execute(Interpreter& m) const { m.eax = (int32_t)((uint32_t)m.load(lhs) + (uint32_t)m.eax); }
+
+void Sub::execute(Interpreter& m) const
+{
+    m.eax = (int32_t)((uint32_t)m.load(lhs) - (uint32_t)m.eax);
+    m.store(lhs, m.eax);
+}
+
+void Mul::execute(Interpreter& m) const { m.eax = (int32_t)((uint32_t)m.load(lhs) * (uint32_t)m.eax); }
+void Div::execute(Interpreter& m) const { m.eax = divide(m, m.load(lhs), m.eax, false); }
+void Mod::execute(Interpreter& m) const { m.eax = divide(m, m.load(lhs), m.eax, true); }
+void Negate::execute(Interpreter& m) const { m.eax = (int32_t)(0u - (uint32_t)m.eax); }
+void LogicalNot::execute(Interpreter& m) const { m.eax = m.eax == 0; }
+void BitAnd::execute(Interpreter& m) const { m.eax &= m.load(lhs); }
+void BitXor::execute(Interpreter& m) const { m.eax ^= m.load(lhs); }
+void BitOr::execute(Interpreter& m) const { m.eax |= m.load(lhs); }
+void CompGt::execute(Interpreter& m) const { m.eax = m.load(lhs) > m.eax; }
+void CompLt::execute(Interpreter& m) const { m.eax = m.load(lhs) < m.eax; }
+void CompGtEq::execute(Interpreter& m) const { m.eax = m.load(lhs) >= m.eax; }
+void CompLtEq::execute(Interpreter& m) const { m.eax = m.load(lhs) <= m.eax; }
+void CompEq::execute(Interpreter& m) const { m.eax = m.load(lhs) == m.eax; }
+void CompNe::execute(Interpreter& m) const { m.eax = m.load(lhs) != m.eax; }
+void CastBool::execute(Interpreter& m) const { m.eax = m.eax != 0; }
+
+void BrTrue::execute(Interpreter& m) const
+{
+    if (m.eax != 0) m.jump(target);
+}
+
+void Br::execute(Interpreter& m) const { m.jump(target); }
+void Return::execute(Interpreter& m) const { m.ret(); }
+
+void PutString::execute(Interpreter& m) const
+{
+    m.write(text);
+    m.eax = (unsigned char)text.back();
+}
+
+// the profile is only collected by the generated code
+void ProfileEnter::execute(Interpreter& m) const {}
+void ProfileExit::execute(Interpreter& m) const {}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+#include "Variable.h"
+
+namespace IR {
+
+class ControlFlowGraph;
+class BasicBlock;
+
+/*
+    Executes the IR of a ControlFlowGraph without generating code (--interp).
+
+    The machine mirrors the generated x86 code: a byte addressed stack where the variables live at
+    %rbp + Variable::offset, the accumulator %eax, the argument registers and the return addresses.
+    Each instruction executes itself through Instruction::execute, like generateAsm.
+    The blocks are run as in BasicBlock::generateAsm: exitTrue is taken if %eax is not 0, then exitFalse,
+    otherwise the execution falls through to the next block.
+
+    The execution stops on an error (division by zero, stack overflow...) or when a limit is reached:
+    run() returns false and getError() tells why.
+*/
+class Interpreter {
+public:
+    Interpreter(const ControlFlowGraph& cfg, std::istream& in, std::ostream& out);
+    Interpreter(const std::vector<const ControlFlowGraph*>& program, std::istream& in, std::ostream& out); // the graphs of the functions (-j N)
+
+    void setLimits(uint64_t maxSteps, size_t maxDepth, uint64_t maxTotalSteps = 0); // 0 for no limit, maxTotalSteps bounds all the runs together
+    inline void setIOAllowed(bool allowed) { _ioAllowed = allowed; }
+
+    bool run(const std::string& function, const std::vector<int>& args, int& result);
+    inline const std::string& getError() const { return _error; }
+    inline uint64_t getSteps() const { return _steps; }
+    inline uint64_t getTotalSteps() const { return _totalSteps; }
+    inline bool isTotalStepLimitReached() const { return _maxTotalSteps && _totalSteps >= _maxTotalSteps; }
+
+    // machine state, used by the instructions
+    int32_t eax;
+    int32_t load(const Variable& variable);
+    void store(const Variable& variable, int32_t value);
+    int32_t getRegister(const std::string& name) const;
+    void setRegister(const std::string& name, int32_t value);
+    void enter(int stackSize); // prologue of a function
+    void push(uint64_t value);
+    void call(const std::string& function, size_t argCount);
+    void ret();
+    void jump(const BasicBlock& target);
+    void write(const std::string& text);
+    void fail(const std::string& error);
+
+protected:
+    struct Frame {
+        size_t block; // block and instruction to come back to, _blocks.size() to go back to run()
+        size_t instruction;
+        size_t argCount;
+    };
+
+    uint64_t pop();
+    bool checkAddress(uint64_t address, size_t size);
+
+    std::vector<const BasicBlock*> _blocks;
+    std::map<const BasicBlock*, size_t> _blockIndex;
+    std::map<std::string, size_t> _functions; // entry block of each function
+    std::istream& _in;
+    std::ostream& _out;
+    bool _ioAllowed;
+
+    std::vector<uint8_t> _stack;
+    uint64_t _rsp;
+    uint64_t _rbp;
+    int32_t _registers[16];
+    std::vector<Frame> _callStack;
+
+    size_t _block; // program counter
+    size_t _instruction;
+    bool _running;
+    std::string _error;
+    uint64_t _steps;
+    uint64_t _maxSteps;
+    size_t _maxDepth;
+    uint64_t _totalSteps;
+    uint64_t _maxTotalSteps;
+};
+
+}
@@ -0,0 +1,246 @@
+#include "Instruction.h"
+#include "Block.h"
+#include "ControlFlowGraph.h"
+#include "Runtime.h"
+
+using namespace IR;
+using namespace x86;
+
+/*
+    x86-64 machine code of the instructions (-c).
+    Each generateCode must encode exactly the assembly written by the generateAsm of Instruction.cpp
+*/
+
+static const Reg ACC = RAX; // reg() of Instruction.cpp
+static const Reg paramRegisters[] = { RDI, RSI, RDX, RCX, R8, R9 };
+
+static void generateCodeComp(const Instruction& inst, Encoder& e, const Variable& lhs, Cond cond) {
+    e.alul(Encoder::CMP, ACC, inst.varToMem(lhs));
+    e.setcc(cond, ACC);
+    e.andb(1, ACC);
+    e.movzbl(ACC, ACC);
+}
+
+static void generateCodeRdtsc(Encoder& e) {
+    e.rdtsc();
+    e.shlq(32, RDX);
+    e.aluq(Encoder::OR, RDX, RAX);
+    e.movq(RAX, RSI);
+}
+
+Mem Instruction::varToMem(const Variable& variable) const
+{
+    return Mem(RBP, variable.offset);
+}
+
+void GenFunc::generateCode(Encoder& e) const
+{
+    e.pushq(RBP);
+    e.movq(RSP, RBP);
+    e.aluq(Encoder::SUB, ((stackSize + 15) / 16) * 16, RSP);
+
+    if (!name.compare("main")) return;
+
+    for (int i = 0; i < varList.size() && i < 6; ++i)
+        e.movl(paramRegisters[i], varToMem(varList[i]));
+}
+
+void MovToReg::generateCode(Encoder& e) const
+{
+    e.movl(varToMem(var), regFromName(reg));
+}
+
+void PushQ::generateCode(Encoder& e) const
+{
+    e.pushq(RDI);
+}
+
+void CallFunc::generateCode(Encoder& e) const
+{
+    if (block.getCFG().getOptions().bufferedIO) {
+        if (name == "putchar") {
+            std::string slowPath = e.newLabel();
+            std::string end = e.newLabel();
+            e.movl(Mem::rip("__ifcc_outpos"), RAX);
+            e.alul(Encoder::CMP, IO_BUFFER_SIZE, RAX);
+            e.jcc(AE, slowPath);
+            e.leaq(Mem::rip("__ifcc_outbuf"), RDX);
+            e.movb(RDI, Mem(RDX, RAX));
+            e.alul(Encoder::ADD, 1, RAX);
+            e.movl(RAX, Mem::rip("__ifcc_outpos"));
+            e.movzbl(RDI, RAX);
+            e.jmp(end);
+            e.bind(slowPath);
+            e.call("__ifcc_putchar");
+            e.bind(end);
+            return;
+        }
+        if (name == "getchar") {
+            e.call("__ifcc_getchar");
+            return;
+        }
+    }
+    e.call(name);
+    if (!varList.empty() && varList.size() > 6)
+        e.aluq(Encoder::ADD, (varList.size() - 6) * 8, RSP);
+}
+
+void LdConst::generateCode(Encoder& e) const
+{
+    e.movl(value, ACC);
+}
+
+void LdLoc::generateCode(Encoder& e) const
+{
+    e.movl(varToMem(loc), ACC);
+}
+
+void Store::generateCode(Encoder& e) const
+{
+    e.movl(ACC, varToMem(loc));
+}
+
+void Add::generateCode(Encoder& e) const
+{
+    e.alul(Encoder::ADD, varToMem(lhs), ACC);
+}
+
+void Sub::generateCode(Encoder& e) const
+{
+    e.alul(Encoder::SUB, ACC, varToMem(lhs));
+    LdLoc(block, lhs).generateCode(e);
+}
+
+void Mul::generateCode(Encoder& e) const
+{
+    e.imull(varToMem(lhs), ACC);
+}
+
+void Div::generateCode(Encoder& e) const
+{
+    e.movl(ACC, RBX);
+    LdLoc(block, lhs).generateCode(e);
+    e.cltd();
+    e.idivl(RBX);
+}
+
+void Mod::generateCode(Encoder& e) const
+{
+    Div(block, lhs).generateCode(e);
+    e.movl(RDX, ACC);
+}
+
+void Negate::generateCode(Encoder& e) const
+{
+    e.negl(ACC);
+}
+
+void LogicalNot::generateCode(Encoder& e) const
+{
+    e.alul(Encoder::CMP, 0, ACC);
+    e.setcc(E, ACC);
+    e.andb(1, ACC);
+    e.movzbl(ACC, ACC);
+}
+
+void BitAnd::generateCode(Encoder& e) const
+{
+    e.alul(Encoder::AND, varToMem(lhs), ACC);
+}
+
+void BitXor::generateCode(Encoder& e) const
+{
+    e.alul(Encoder::XOR, varToMem(lhs), ACC);
+}
+
+void BitOr::generateCode(Encoder& e) const
+{
+    e.alul(Encoder::OR, varToMem(lhs), ACC);
+}
+
+void CompGt::generateCode(Encoder& e) const { generateCodeComp(*this, e, lhs, G); }
+void CompLt::generateCode(Encoder& e) const { generateCodeComp(*this, e, lhs, L); }
+void CompGtEq::generateCode(Encoder& e) const { generateCodeComp(*this, e, lhs, GE); }
+void CompLtEq::generateCode(Encoder& e) const { generateCodeComp(*this, e, lhs, LE); }
+void CompEq::generateCode(Encoder& e) const { generateCodeComp(*this, e, lhs, E); }
+void CompNe::generateCode(Encoder& e) const { generateCodeComp(*this, e, lhs, NE); }
+
+void Return::generateCode(Encoder& e) const
+{
+    e.movq(RBP, RSP);
+    e.popq(RBP);
+    e.ret();
+}
+
+void Br::generateCode(Encoder& e) const
+{
+    e.jmp(target.getLabel());
+}
+
+void BrTrue::generateCode(Encoder& e) const
+{
+    e.alul(Encoder::CMP, 0, ACC);
+    e.jcc(NE, target.getLabel());
+}
+
+void CastBool::generateCode(Encoder& e) const
+{
+    e.alul(Encoder::CMP, 0, ACC);
+    e.setcc(NE, ACC);
+    e.alul(Encoder::AND, 1, ACC);
+}
+
+void PutString::generateCode(Encoder& e) const
+{
+    std::string label = getLabel();
+    e.pushSection(RODATA);
+    e.bind(label);
+    e.bytes(text);
+    e.popSection();
+
+    e.leaq(Mem::rip(label), RDI);
+    if (block.getCFG().getOptions().bufferedIO) {
+        e.movl(text.size(), RSI);
+        e.call("__ifcc_write");
+    }
+    else {
+        e.movl(1, RSI);
+        e.movl(text.size(), RDX);
+        e.movq(Mem::rip("stdout", RelocType::GotPCRel), RCX);
+        e.movq(Mem(RCX), RCX);
+        e.call("fwrite");
+    }
+    e.movl((int)(unsigned char)text.back(), ACC);
+}
+
+void ProfileEnter::generateCode(Encoder& e) const
+{
+    e.pushSection(RODATA);
+    e.bind(".Lprof_name_" + name);
+    e.bytes(name + '\0');
+    e.switchSection(DATA);
+    e.align(8);
+    e.bind(".Lprof_" + name);
+    e.quad(".Lprof_name_" + name);
+    e.zero(40);
+    e.popSection();
+
+    e.pushq(RAX);
+    e.aluq(Encoder::SUB, 8, RSP);
+    generateCodeRdtsc(e);
+    e.leaq(Mem::rip(".Lprof_" + name), RDI);
+    e.call("__ifcc_prof_enter");
+    e.aluq(Encoder::ADD, 8, RSP);
+    e.popq(RAX);
+}
+
+void ProfileExit::generateCode(Encoder& e) const
+{
+    e.pushq(RAX);
+    e.aluq(Encoder::SUB, 8, RSP);
+    generateCodeRdtsc(e);
+    e.leaq(Mem::rip(".Lprof_" + name), RDI);
+    e.call("__ifcc_prof_exit");
+    e.aluq(Encoder::ADD, 8, RSP);
+    e.popq(RAX);
+}
@@ -0,0 +1,287 @@
+#include "Runtime.h"
+
+using namespace IR;
+
+/*
+    Linux x86-64 syscalls used: read (0), write (1), exit_group (231)
+    syscall clobbers %rcx and %r11, -4 is -EINTR
+*/
+
+static void generateStart(AsmBuffer& o)
+{
+    o << "\t.globl\t_start\n";
+    o << "_start:\n";
+    o << "\txorl\t%ebp, %ebp # outermost frame\n";
+    o << "\tandq\t$-16, %rsp\n";
+    o << "\tcall\tmain\n";
+    o << "\tmovl\t%eax, %ebx # keep the exit code\n";
+    o << "\tcall\t__ifcc_flush\n";
+    o << "\tmovl\t%ebx, %edi\n";
+    o << "\tmovl\t$231, %eax\n";
+    o << "\tsyscall\n";
+}
+
+static void generateFlush(AsmBuffer& o)
+{
+    o << "__ifcc_flush:\n";
+    o << "\tpushq\t%rbx\n";
+    o << "\txorl\t%ebx, %ebx # bytes written\n";
+    o << "1:\n";
+    o << "\tmovl\t__ifcc_outpos(%rip), %edx\n";
+    o << "\tsubl\t%ebx, %edx\n";
+    o << "\tjle\t2f\n";
+    o << "\tmovl\t$1, %eax\n";
+    o << "\tmovl\t$1, %edi\n";
+    o << "\tleaq\t__ifcc_outbuf(%rip), %rsi\n";
+    o << "\taddq\t%rbx, %rsi\n";
+    o << "\tsyscall\n";
+    o << "\tcmpq\t$-4, %rax\n";
+    o << "\tje\t1b\n";
+    o << "\ttestq\t%rax, %rax\n";
+    o << "\tjle\t2f\n";
+    o << "\taddl\t%eax, %ebx\n";
+    o << "\tjmp\t1b\n";
+    o << "2:\n";
+    o << "\tmovl\t$0, __ifcc_outpos(%rip)\n";
+    o << "\tpopq\t%rbx\n";
+    o << "\tret\n";
+}
+
+static void generatePutchar(AsmBuffer& o)
+{
+    o << "__ifcc_putchar:\n";
+    o << "\tmovl\t__ifcc_outpos(%rip), %eax\n";
+    o << "\tcmpl\t$" << IO_BUFFER_SIZE << ", %eax\n";
+    o << "\tjb\t1f\n";
+    o << "\tpushq\t%rdi\n";
+    o << "\tcall\t__ifcc_flush\n";
+    o << "\tpopq\t%rdi\n";
+    o << "\txorl\t%eax, %eax\n";
+    o << "1:\n";
+    o << "\tleaq\t__ifcc_outbuf(%rip), %rdx\n";
+    o << "\tmovb\t%dil, (%rdx,%rax)\n";
+    o << "\taddl\t$1, %eax\n";
+    o << "\tmovl\t%eax, __ifcc_outpos(%rip)\n";
+    o << "\tmovzbl\t%dil, %eax\n";
+    o << "\tret\n";
+}
+
+static void generateWrite(AsmBuffer& o)
+{
+    o << "__ifcc_write:\n";
+    o << "\tpushq\t%rbx\n";
+    o << "\tpushq\t%r12\n";
+    o << "\tpushq\t%r13\n";
+    o << "\tmovq\t%rdi, %r12 # text\n";
+    o << "\tmovl\t%esi, %r13d # length\n";
+    o << "\txorl\t%ebx, %ebx\n";
+    o << "1:\n";
+    o << "\tcmpl\t%r13d, %ebx\n";
+    o << "\tjae\t3f\n";
+    o << "\tmovl\t__ifcc_outpos(%rip), %eax\n";
+    o << "\tcmpl\t$" << IO_BUFFER_SIZE << ", %eax\n";
+    o << "\tjb\t2f\n";
+    o << "\tcall\t__ifcc_flush\n";
+    o << "\txorl\t%eax, %eax\n";
+    o << "2:\n";
+    o << "\tmovzbl\t(%r12,%rbx), %ecx\n";
+    o << "\tleaq\t__ifcc_outbuf(%rip), %rdx\n";
+    o << "\tmovb\t%cl, (%rdx,%rax)\n";
+    o << "\taddl\t$1, %eax\n";
+    o << "\tmovl\t%eax, __ifcc_outpos(%rip)\n";
+    o << "\taddl\t$1, %ebx\n";
+    o << "\tjmp\t1b\n";
+    o << "3:\n";
+    o << "\tpopq\t%r13\n";
+    o << "\tpopq\t%r12\n";
+    o << "\tpopq\t%rbx\n";
+    o << "\tret\n";
+}
+
+static void generateGetchar(AsmBuffer& o)
+{
+    o << "__ifcc_getchar:\n";
+    o << "\tmovl\t.Lifcc_inpos(%rip), %eax\n";
+    o << "\tcmpl\t.Lifcc_inlen(%rip), %eax\n";
+    o << "\tjb\t2f\n";
+    o << "\tsubq\t$8, %rsp\n";
+    o << "\tcall\t__ifcc_flush # an interactive program must see its prompt before waiting for input\n";
+    o << "1:\n";
+    o << "\txorl\t%eax, %eax\n";
+    o << "\txorl\t%edi, %edi\n";
+    o << "\tleaq\t.Lifcc_inbuf(%rip), %rsi\n";
+    o << "\tmovl\t$" << IO_BUFFER_SIZE << ", %edx\n";
+    o << "\tsyscall\n";
+    o << "\tcmpq\t$-4, %rax\n";
+    o << "\tje\t1b\n";
+    o << "\taddq\t$8, %rsp\n";
+    o << "\ttestq\t%rax, %rax\n";
+    o << "\tjg\t3f\n";
+    o << "\tmovl\t$-1, %eax # EOF\n";
+    o << "\tret\n";
+    o << "3:\n";
+    o << "\tmovl\t%eax, .Lifcc_inlen(%rip)\n";
+    o << "\txorl\t%eax, %eax\n";
+    o << "2:\n";
+    o << "\tleaq\t.Lifcc_inbuf(%rip), %rdx\n";
+    o << "\tmovzbl\t(%rdx,%rax), %ecx\n";
+    o << "\taddl\t$1, %eax\n";
+    o << "\tmovl\t%eax, .Lifcc_inpos(%rip)\n";
+    o << "\tmovl\t%ecx, %eax\n";
+    o << "\tret\n";
+}
+
+void IR::generateFreestandingRuntime(AsmBuffer& o)
+{
+    o << "\t# freestanding runtime\n";
+    o << "\t.text\n";
+    generateStart(o);
+    generateFlush(o);
+    generatePutchar(o);
+    generateWrite(o);
+    generateGetchar(o);
+
+    o << "\t.bss\n";
+    o << "__ifcc_outbuf:\n\t.zero\t" << IO_BUFFER_SIZE << "\n";
+    o << "__ifcc_outpos:\n\t.zero\t4\n";
+    o << ".Lifcc_inbuf:\n\t.zero\t" << IO_BUFFER_SIZE << "\n";
+    o << ".Lifcc_inpos:\n\t.zero\t4\n";
+    o << ".Lifcc_inlen:\n\t.zero\t4\n";
+}
+
+// Machine code of the freestanding runtime (-c), same code as above
+void IR::generateFreestandingRuntime(x86::Encoder& e)
+{
+    using namespace x86;
+    e.switchSection(TEXT);
+
+    e.bind("_start", true);
+    e.alul(Encoder::XOR, RBP, RBP);
+    e.aluq(Encoder::AND, -16, RSP);
+    e.call("main");
+    e.movl(RAX, RBX);
+    e.call("__ifcc_flush");
+    e.movl(RBX, RDI);
+    e.movl(231, RAX);
+    e.syscall();
+
+    {
+        std::string loop = e.newLabel(), end = e.newLabel();
+        e.bind("__ifcc_flush");
+        e.pushq(RBX);
+        e.alul(Encoder::XOR, RBX, RBX);
+        e.bind(loop);
+        e.movl(Mem::rip("__ifcc_outpos"), RDX);
+        e.alul(Encoder::SUB, RBX, RDX);
+        e.jcc(LE, end);
+        e.movl(1, RAX);
+        e.movl(1, RDI);
+        e.leaq(Mem::rip("__ifcc_outbuf"), RSI);
+        e.aluq(Encoder::ADD, RBX, RSI);
+        e.syscall();
+        e.aluq(Encoder::CMP, -4, RAX);
+        e.jcc(E, loop);
+        e.testq(RAX, RAX);
+        e.jcc(LE, end);
+        e.alul(Encoder::ADD, RAX, RBX);
+        e.jmp(loop);
+        e.bind(end);
+        e.movl(0, Mem::rip("__ifcc_outpos"));
+        e.popq(RBX);
+        e.ret();
+    }
+    {
+        std::string store = e.newLabel();
+        e.bind("__ifcc_putchar");
+        e.movl(Mem::rip("__ifcc_outpos"), RAX);
+        e.alul(Encoder::CMP, IO_BUFFER_SIZE, RAX);
+        e.jcc(B, store);
+        e.pushq(RDI);
+        e.call("__ifcc_flush");
+        e.popq(RDI);
+        e.alul(Encoder::XOR, RAX, RAX);
+        e.bind(store);
+        e.leaq(Mem::rip("__ifcc_outbuf"), RDX);
+        e.movb(RDI, Mem(RDX, RAX));
+        e.alul(Encoder::ADD, 1, RAX);
+        e.movl(RAX, Mem::rip("__ifcc_outpos"));
+        e.movzbl(RDI, RAX);
+        e.ret();
+    }
+    {
+        std::string loop = e.newLabel(), store = e.newLabel(), end = e.newLabel();
+        e.bind("__ifcc_write");
+        e.pushq(RBX);
+        e.pushq(R12);
+        e.pushq(R13);
+        e.movq(RDI, R12);
+        e.movl(RSI, R13);
+        e.alul(Encoder::XOR, RBX, RBX);
+        e.bind(loop);
+        e.alul(Encoder::CMP, R13, RBX);
+        e.jcc(AE, end);
+        e.movl(Mem::rip("__ifcc_outpos"), RAX);
+        e.alul(Encoder::CMP, IO_BUFFER_SIZE, RAX);
+        e.jcc(B, store);
+        e.call("__ifcc_flush");
+        e.alul(Encoder::XOR, RAX, RAX);
+        e.bind(store);
+        e.movzbl(Mem(R12, RBX), RCX);
+        e.leaq(Mem::rip("__ifcc_outbuf"), RDX);
+        e.movb(RCX, Mem(RDX, RAX));
+        e.alul(Encoder::ADD, 1, RAX);
+        e.movl(RAX, Mem::rip("__ifcc_outpos"));
+        e.alul(Encoder::ADD, 1, RBX);
+        e.jmp(loop);
+        e.bind(end);
+        e.popq(R13);
+        e.popq(R12);
+        e.popq(RBX);
+        e.ret();
+    }
+    {
+        std::string read = e.newLabel(), load = e.newLabel(), filled = e.newLabel();
+        e.bind("__ifcc_getchar");
+        e.movl(Mem::rip(".Lifcc_inpos"), RAX);
+        e.alul(Encoder::CMP, Mem::rip(".Lifcc_inlen"), RAX);
+        e.jcc(B, load);
+        e.aluq(Encoder::SUB, 8, RSP);
+        e.call("__ifcc_flush");
+        e.bind(read);
+        e.alul(Encoder::XOR, RAX, RAX);
+        e.alul(Encoder::XOR, RDI, RDI);
+        e.leaq(Mem::rip(".Lifcc_inbuf"), RSI);
+        e.movl(IO_BUFFER_SIZE, RDX);
+        e.syscall();
+        e.aluq(Encoder::CMP, -4, RAX);
+        e.jcc(E, read);
+        e.aluq(Encoder::ADD, 8, RSP);
+        e.testq(RAX, RAX);
+        e.jcc(G, filled);
+        e.movl(-1, RAX);
+        e.ret();
+        e.bind(filled);
+        e.movl(RAX, Mem::rip(".Lifcc_inlen"));
+        e.alul(Encoder::XOR, RAX, RAX);
+        e.bind(load);
+        e.leaq(Mem::rip(".Lifcc_inbuf"), RDX);
+        e.movzbl(Mem(RDX, RAX), RCX);
+        e.alul(Encoder::ADD, 1, RAX);
+        e.movl(RAX, Mem::rip(".Lifcc_inpos"));
+        e.movl(RCX, RAX);
+        e.ret();
+    }
+
+    e.switchSection(BSS);
+    e.bind("__ifcc_outbuf");
+    e.zero(IO_BUFFER_SIZE);
+    e.bind("__ifcc_outpos");
+    e.zero(4);
+    e.bind(".Lifcc_inbuf");
+    e.zero(IO_BUFFER_SIZE);
+    e.bind(".Lifcc_inpos");
+    e.zero(4);
+    e.bind(".Lifcc_inlen");
+    e.zero(4);
+    e.switchSection(TEXT);
+}
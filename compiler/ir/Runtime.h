@@ -0,0 +1,16 @@
+#pragma once
+
+#include <iostream>
+#include "../x86/Encoder.h"
+#include "AsmBuffer.h"
+
+namespace IR {
+
+// Size of __ifcc_outbuf, must be the same as IFCC_IO_BUFFER_SIZE in runtime/ifcc_io.c
+const int IO_BUFFER_SIZE = 4096;
+
+// -ffreestanding: generates _start and the I/O runtime (same symbols as runtime/ifcc_io.c) on top of raw syscalls
+void generateFreestandingRuntime(AsmBuffer& o);
+void generateFreestandingRuntime(x86::Encoder& e);
+
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include "../Symbol.h"
+
+namespace IR {
+
+struct Variable {
+    Variable(Symbol name, int offset, uint32_t id) : name(name), offset(offset), id(id) {}
+    Symbol name; // NO_SYMBOL for the temporaries
+    int offset;
+    uint32_t id; // index of the variable in its graph, see ControlFlowGraph::getVariables
+};
+
+}
@@ -0,0 +1,325 @@
+#include <iostream>
+#include "Encoder.h"
+#include "../CompileError.h"
+
+using namespace x86;
+
+Reg x86::regFromName(const std::string& name)
+{
+    static const std::map<std::string, Reg> registers = {
+        {"%eax", RAX}, {"%ecx", RCX}, {"%edx", RDX}, {"%ebx", RBX}, {"%esp", RSP}, {"%ebp", RBP}, {"%esi", RSI}, {"%edi", RDI},
+        {"%r8d", R8}, {"%r9d", R9}, {"%r10d", R10}, {"%r11d", R11}, {"%r12d", R12}, {"%r13d", R13}, {"%r14d", R14}, {"%r15d", R15},
+        {"%rax", RAX}, {"%rcx", RCX}, {"%rdx", RDX}, {"%rbx", RBX}, {"%rsp", RSP}, {"%rbp", RBP}, {"%rsi", RSI}, {"%rdi", RDI},
+        {"%r8", R8}, {"%r9", R9}, {"%r10", R10}, {"%r11", R11}, {"%r12", R12}, {"%r13", R13}, {"%r14", R14}, {"%r15", R15},
+    };
+    auto it = registers.find(name);
+    if (it == registers.end()) {
+        throw CompileError("unknown register " + name);
+    }
+    return it->second;
+}
+
+Mem Mem::rip(const std::string& symbol, RelocType type)
+{
+    Mem mem(NOREG);
+    mem.symbol = symbol;
+    mem.relocType = type;
+    return mem;
+}
+
+Encoder::Encoder() : _current(TEXT), _labelCount(0)
+{
+    _sections[TEXT].align = 16;
+    _sections[DATA].align = 8;
+    _sections[BSS].align = 32;
+}
+
+// ---------------------------------------------------------------- sections and data
+
+void Encoder::switchSection(Section section)
+{
+    _current = section;
+}
+
+void Encoder::pushSection(Section section)
+{
+    _sectionStack.push_back(_current);
+    _current = section;
+}
+
+void Encoder::popSection()
+{
+    _current = _sectionStack.back();
+    _sectionStack.pop_back();
+}
+
+void Encoder::align(uint32_t alignment)
+{
+    auto& section = _sections[_current];
+    if (alignment > section.align) section.align = alignment;
+    uint64_t size = _current == BSS ? section.size : section.bytes.size();
+    zero((alignment - size % alignment) % alignment);
+}
+
+void Encoder::bytes(const std::string& data)
+{
+    _sections[_current].bytes.insert(_sections[_current].bytes.end(), data.begin(), data.end());
+}
+
+void Encoder::zero(uint64_t count)
+{
+    if (_current == BSS) _sections[BSS].size += count;
+    else _sections[_current].bytes.insert(_sections[_current].bytes.end(), count, 0);
+}
+
+void Encoder::quad(const std::string& symbol)
+{
+    reference(symbol, RelocType::Abs64, 0);
+    zero(8);
+}
+
+// ---------------------------------------------------------------- symbols
+
+size_t Encoder::symbol(const std::string& name)
+{
+    auto it = _symbolIndex.find(name);
+    if (it != _symbolIndex.end()) return it->second;
+    Symbol symbol;
+    symbol.name = name;
+    _symbols.push_back(symbol);
+    _symbolIndex[name] = _symbols.size() - 1;
+    return _symbols.size() - 1;
+}
+
+void Encoder::bind(const std::string& name, bool global)
+{
+    Symbol& s = _symbols[symbol(name)];
+    s.section = _current;
+    s.offset = _current == BSS ? _sections[BSS].size : _sections[_current].bytes.size();
+    s.global = s.global || global;
+}
+
+std::string Encoder::newLabel()
+{
+    return ".Lenc" + std::to_string(_labelCount++);
+}
+
+void Encoder::reference(const std::string& name, RelocType type, int64_t addend)
+{
+    _fixups.push_back({ _current, _sections[_current].bytes.size(), symbol(name), type, addend });
+}
+
+void Encoder::finish()
+{
+    for (auto& section : _sections) {
+        if (&section != &_sections[BSS]) section.size = section.bytes.size();
+    }
+    for (const auto& fixup : _fixups) {
+        const Symbol& s = _symbols[fixup.symbol];
+        bool pcRelative = fixup.type == RelocType::PC32 || fixup.type == RelocType::PLT32;
+        if (pcRelative && s.section == fixup.section && !s.global) {
+            int32_t value = (int32_t)(s.offset + fixup.addend - fixup.offset);
+            auto& bytes = _sections[fixup.section].bytes;
+            for (int i = 0; i < 4; ++i) bytes[fixup.offset + i] = (uint8_t)(value >> (8 * i));
+        }
+        else _relocations.push_back({ fixup.section, fixup.offset, fixup.symbol, fixup.type, fixup.addend });
+    }
+    _fixups.clear();
+}
+
+// ---------------------------------------------------------------- encoding helpers
+
+void Encoder::byte(uint8_t b)
+{
+    _sections[_current].bytes.push_back(b);
+}
+
+void Encoder::int32(int32_t value)
+{
+    for (int i = 0; i < 4; ++i) byte((uint8_t)(value >> (8 * i)));
+}
+
+// byteRegs: %spl, %bpl, %sil and %dil can only be encoded with a REX prefix
+void Encoder::rex(bool w, int reg, int index, int base, bool byteRegs)
+{
+    uint8_t value = 0x40 | (w << 3) | (((reg >> 3) & 1) << 2) | (((index >> 3) & 1) << 1) | ((base >> 3) & 1);
+    if (value != 0x40 || byteRegs) byte(value);
+}
+
+void Encoder::modrm(int reg, Reg rm)
+{
+    byte(0xC0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+void Encoder::modrm(int reg, const Mem& rm, int immSize)
+{
+    if (rm.base == NOREG) {
+        // symbol(%rip): the displacement is relative to the end of the instruction
+        byte(0x05 | ((reg & 7) << 3));
+        reference(rm.symbol, rm.relocType, -(4 + immSize));
+        int32(0);
+        return;
+    }
+
+    int mod;
+    if (rm.disp == 0 && (rm.base & 7) != RBP) mod = 0;
+    else if (rm.disp >= -128 && rm.disp <= 127) mod = 1;
+    else mod = 2;
+
+    if (rm.index != NOREG) {
+        byte((mod << 6) | ((reg & 7) << 3) | 4);
+        byte(((rm.index & 7) << 3) | (rm.base & 7));
+    }
+    else if ((rm.base & 7) == RSP) {
+        byte((mod << 6) | ((reg & 7) << 3) | 4);
+        byte(0x24);
+    }
+    else byte((mod << 6) | ((reg & 7) << 3) | (rm.base & 7));
+
+    if (mod == 1) byte((uint8_t)rm.disp);
+    else if (mod == 2) int32(rm.disp);
+}
+
+void Encoder::opRR(std::initializer_list<uint8_t> opcode, int reg, Reg rm, bool w, bool byteRegs)
+{
+    rex(w, reg, 0, rm, byteRegs);
+    for (uint8_t b : opcode) byte(b);
+    modrm(reg, rm);
+}
+
+void Encoder::opRM(std::initializer_list<uint8_t> opcode, int reg, const Mem& rm, bool w, bool byteRegs, int immSize)
+{
+    rex(w, reg, rm.index == NOREG ? 0 : rm.index, rm.base == NOREG ? 0 : rm.base, byteRegs);
+    for (uint8_t b : opcode) byte(b);
+    modrm(reg, rm, immSize);
+}
+
+static bool needsRex8(Reg reg)
+{
+    return reg >= RSP && reg <= RDI;
+}
+
+// ---------------------------------------------------------------- instructions
+
+void Encoder::movl(Reg src, Reg dst) { opRR({ 0x89 }, src, dst, false); }
+void Encoder::movl(Reg src, const Mem& dst) { opRM({ 0x89 }, src, dst, false); }
+void Encoder::movl(const Mem& src, Reg dst) { opRM({ 0x8B }, dst, src, false); }
+
+void Encoder::movl(int32_t imm, Reg dst)
+{
+    rex(false, 0, 0, dst, false);
+    byte(0xB8 + (dst & 7));
+    int32(imm);
+}
+
+void Encoder::movl(int32_t imm, const Mem& dst)
+{
+    opRM({ 0xC7 }, 0, dst, false, false, 4);
+    int32(imm);
+}
+
+void Encoder::movq(Reg src, Reg dst) { opRR({ 0x89 }, src, dst, true); }
+void Encoder::movq(const Mem& src, Reg dst) { opRM({ 0x8B }, dst, src, true); }
+void Encoder::movb(Reg src, const Mem& dst) { opRM({ 0x88 }, src, dst, false, needsRex8(src)); }
+void Encoder::movzbl(Reg src, Reg dst) { opRR({ 0x0F, 0xB6 }, dst, src, false, needsRex8(src)); }
+void Encoder::movzbl(const Mem& src, Reg dst) { opRM({ 0x0F, 0xB6 }, dst, src, false); }
+void Encoder::leaq(const Mem& src, Reg dst) { opRM({ 0x8D }, dst, src, true); }
+
+void Encoder::alul(Alu op, Reg src, Reg dst) { opRR({ (uint8_t)(op * 8 + 1) }, src, dst, false); }
+void Encoder::alul(Alu op, const Mem& src, Reg dst) { opRM({ (uint8_t)(op * 8 + 3) }, dst, src, false); }
+void Encoder::alul(Alu op, Reg src, const Mem& dst) { opRM({ (uint8_t)(op * 8 + 1) }, src, dst, false); }
+
+void Encoder::alul(Alu op, int32_t imm, Reg dst)
+{
+    if (imm >= -128 && imm <= 127) {
+        opRR({ 0x83 }, op, dst, false);
+        byte((uint8_t)imm);
+    }
+    else {
+        opRR({ 0x81 }, op, dst, false);
+        int32(imm);
+    }
+}
+
+void Encoder::aluq(Alu op, Reg src, Reg dst) { opRR({ (uint8_t)(op * 8 + 1) }, src, dst, true); }
+
+void Encoder::aluq(Alu op, int32_t imm, Reg dst)
+{
+    if (imm >= -128 && imm <= 127) {
+        opRR({ 0x83 }, op, dst, true);
+        byte((uint8_t)imm);
+    }
+    else {
+        opRR({ 0x81 }, op, dst, true);
+        int32(imm);
+    }
+}
+
+void Encoder::andb(int8_t imm, Reg dst)
+{
+    opRR({ 0x80 }, AND, dst, false, needsRex8(dst));
+    byte((uint8_t)imm);
+}
+
+void Encoder::imull(const Mem& src, Reg dst) { opRM({ 0x0F, 0xAF }, dst, src, false); }
+void Encoder::negl(Reg reg) { opRR({ 0xF7 }, 3, reg, false); }
+void Encoder::idivl(Reg reg) { opRR({ 0xF7 }, 7, reg, false); }
+void Encoder::cltd() { byte(0x99); }
+
+void Encoder::shlq(uint8_t imm, Reg reg)
+{
+    opRR({ 0xC1 }, 4, reg, true);
+    byte(imm);
+}
+
+void Encoder::testq(Reg src, Reg dst) { opRR({ 0x85 }, src, dst, true); }
+
+void Encoder::pushq(Reg reg)
+{
+    rex(false, 0, 0, reg, false);
+    byte(0x50 + (reg & 7));
+}
+
+void Encoder::popq(Reg reg)
+{
+    rex(false, 0, 0, reg, false);
+    byte(0x58 + (reg & 7));
+}
+
+void Encoder::setcc(Cond cond, Reg dst) { opRR({ 0x0F, (uint8_t)(0x90 + cond) }, 0, dst, false, needsRex8(dst)); }
+
+void Encoder::jmp(const std::string& label)
+{
+    byte(0xE9);
+    reference(label, RelocType::PC32, -4);
+    int32(0);
+}
+
+void Encoder::jcc(Cond cond, const std::string& label)
+{
+    byte(0x0F);
+    byte(0x80 + cond);
+    reference(label, RelocType::PC32, -4);
+    int32(0);
+}
+
+void Encoder::call(const std::string& name)
+{
+    byte(0xE8);
+    reference(name, RelocType::PLT32, -4);
+    int32(0);
+}
+
+void Encoder::ret() { byte(0xC3); }
+
+void Encoder::syscall()
+{
+    byte(0x0F);
+    byte(0x05);
+}
+
+void Encoder::rdtsc()
+{
+    byte(0x0F);
+    byte(0x31);
+}
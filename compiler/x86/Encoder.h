@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+
+namespace x86 {
+
+enum Reg : uint8_t { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15, NOREG = 0xff };
+
+// Condition codes, in the order of the jcc/setcc opcodes
+enum Cond : uint8_t { O, NO, B, AE, E, NE, BE, A, S, NS, P, NP, L, GE, LE, G };
+
+// Same values as the ELF relocation types
+enum class RelocType { Abs64 = 1, PC32 = 2, PLT32 = 4, GotPCRel = 9 };
+
+enum Section { TEXT, RODATA, DATA, BSS, SECTION_COUNT };
+
+// Returns the 64 bits register of an AT&T register name (%eax, %edi, %r8d...)
+Reg regFromName(const std::string& name);
+
+// Memory operand: disp(base, index) or symbol(%rip) when base is NOREG
+struct Mem {
+    Mem(Reg base, int32_t disp = 0) : base(base), index(NOREG), disp(disp), relocType(RelocType::PC32) {}
+    Mem(Reg base, Reg index) : base(base), index(index), disp(0), relocType(RelocType::PC32) {}
+    static Mem rip(const std::string& symbol, RelocType type = RelocType::PC32);
+
+    Reg base;
+    Reg index;
+    int32_t disp;
+    std::string symbol;
+    RelocType relocType;
+};
+
+struct Symbol {
+    std::string name;
+    int section = -1; // -1 if undefined
+    uint64_t offset = 0;
+    bool global = false;
+};
+
+struct Relocation {
+    int section;
+    uint64_t offset;
+    size_t symbol;
+    RelocType type;
+    int64_t addend;
+};
+
+struct SectionData {
+    std::vector<uint8_t> bytes; // empty for BSS
+    uint64_t size = 0;
+    uint32_t align = 1;
+};
+
+/*
+    Encodes x86-64 instructions in sections, like an assembler.
+    The methods follow the AT&T syntax used by generateAsm: the source operand comes first.
+
+    References to symbols are resolved by finish() when possible (local labels of the same section),
+    the others are kept as relocations for the ELF writer or the JIT.
+*/
+class Encoder {
+public:
+    Encoder();
+
+    // sections and data
+    void switchSection(Section section);
+    void pushSection(Section section);
+    void popSection();
+    void align(uint32_t alignment);
+    void bytes(const std::string& data);
+    void zero(uint64_t count);
+    void quad(const std::string& symbol);
+
+    // symbols
+    size_t symbol(const std::string& name);
+    void bind(const std::string& name, bool global = false);
+    std::string newLabel(); // unique local label
+
+    // instructions
+    enum Alu { ADD = 0, OR = 1, AND = 4, SUB = 5, XOR = 6, CMP = 7 };
+    void movl(Reg src, Reg dst);
+    void movl(Reg src, const Mem& dst);
+    void movl(const Mem& src, Reg dst);
+    void movl(int32_t imm, Reg dst);
+    void movl(int32_t imm, const Mem& dst);
+    void movq(Reg src, Reg dst);
+    void movq(const Mem& src, Reg dst);
+    void movb(Reg src, const Mem& dst);
+    void movzbl(Reg src, Reg dst);
+    void movzbl(const Mem& src, Reg dst);
+    void leaq(const Mem& src, Reg dst);
+    void alul(Alu op, Reg src, Reg dst);
+    void alul(Alu op, const Mem& src, Reg dst);
+    void alul(Alu op, Reg src, const Mem& dst);
+    void alul(Alu op, int32_t imm, Reg dst);
+    void aluq(Alu op, Reg src, Reg dst);
+    void aluq(Alu op, int32_t imm, Reg dst);
+    void andb(int8_t imm, Reg dst);
+    void imull(const Mem& src, Reg dst);
+    void negl(Reg reg);
+    void idivl(Reg reg);
+    void cltd();
+    void shlq(uint8_t imm, Reg reg);
+    void testq(Reg src, Reg dst);
+    void pushq(Reg reg);
+    void popq(Reg reg);
+    void setcc(Cond cond, Reg dst);
+    void jmp(const std::string& label);
+    void jcc(Cond cond, const std::string& label);
+    void call(const std::string& symbol);
+    void ret();
+    void syscall();
+    void rdtsc();
+
+    void finish(); // resolves the local references, the others become relocations
+
+    inline const SectionData& getSection(int section) const { return _sections[section]; }
+    inline const std::vector<Symbol>& getSymbols() const { return _symbols; }
+    inline const std::vector<Relocation>& getRelocations() const { return _relocations; }
+
+protected:
+    struct Fixup {
+        int section;
+        uint64_t offset;
+        size_t symbol;
+        RelocType type;
+        int64_t addend;
+    };
+
+    void byte(uint8_t b);
+    void int32(int32_t value);
+    void rex(bool w, int reg, int index, int base, bool byteRegs);
+    void modrm(int reg, Reg rm);
+    void modrm(int reg, const Mem& rm, int immSize);
+    void opRR(std::initializer_list<uint8_t> opcode, int reg, Reg rm, bool w, bool byteRegs = false);
+    void opRM(std::initializer_list<uint8_t> opcode, int reg, const Mem& rm, bool w, bool byteRegs = false, int immSize = 0);
+    void reference(const std::string& symbol, RelocType type, int64_t addend);
+
+    SectionData _sections[SECTION_COUNT];
+    int _current;
+    std::vector<int> _sectionStack;
+    std::vector<Symbol> _symbols;
+    std::map<std::string, size_t> _symbolIndex;
+    std::vector<Fixup> _fixups;
+    std::vector<Relocation> _relocations;
+    int _labelCount; // just for naming
+};
+
+}
@@ -0,0 +1,147 @@
+#include <iostream>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "Jit.h"
+#include "../CompileError.h"
+
+using namespace x86;
+
+static const size_t STUB_SIZE = 8; // jmp *slot(%rip) + padding
+static const uint8_t ENTRY_THUNK[] = { 0x53, 0xFF, 0xD7, 0x5B, 0xC3 }; // pushq %rbx; call *%rdi; popq %rbx; ret
+
+static size_t alignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+Jit::Jit(const Encoder& encoder) : _encoder(encoder), _memory(nullptr), _size(0), _entryThunk(nullptr)
+{
+}
+
+Jit::~Jit()
+{
+    if (_memory) munmap(_memory, _size);
+}
+
+void Jit::bindSymbol(const std::string& name, void* address)
+{
+    _hostSymbols[name] = address;
+}
+
+uint8_t* Jit::allocateSlot(const std::string& name)
+{
+    auto it = _slots.find(name);
+    if (it != _slots.end()) return it->second;
+
+    auto host = _hostSymbols.find(name);
+    if (host == _hostSymbols.end()) {
+        throw CompileError("undefined symbol " + name + " in --run mode");
+    }
+    uint8_t* slot = _sectionAddress[BSS] + alignUp(_encoder.getSection(BSS).size, 8) + _slots.size() * 8;
+    uint64_t address = (uint64_t)host->second;
+    memcpy(slot, &address, 8);
+    _slots[name] = slot;
+    return slot;
+}
+
+void Jit::load()
+{
+    const auto& symbols = _encoder.getSymbols();
+    size_t undefinedCount = 0;
+    for (const auto& s : symbols) {
+        if (s.section == -1) ++undefinedCount;
+    }
+
+    // text and stubs on their own pages (RX), then the data sections and the slots (RW)
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    size_t textSize = _encoder.getSection(TEXT).size;
+    size_t stubsOffset = alignUp(textSize, 16);
+    size_t thunkOffset = stubsOffset + undefinedCount * STUB_SIZE;
+    size_t offset = alignUp(thunkOffset + sizeof(ENTRY_THUNK), pageSize);
+    size_t rxSize = offset;
+    size_t sectionOffset[SECTION_COUNT] = { 0 };
+    for (int section = RODATA; section < SECTION_COUNT; ++section) {
+        offset = alignUp(offset, _encoder.getSection(section).align);
+        sectionOffset[section] = offset;
+        offset += _encoder.getSection(section).size;
+    }
+    offset = alignUp(offset, 8) + undefinedCount * 8; // the slots follow the BSS (see allocateSlot)
+    _size = alignUp(offset, pageSize);
+
+    void* memory = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        throw CompileError("cannot allocate executable memory");
+    }
+    _memory = (uint8_t*)memory;
+    for (int section = TEXT; section < SECTION_COUNT; ++section) {
+        _sectionAddress[section] = _memory + sectionOffset[section];
+        const auto& bytes = _encoder.getSection(section).bytes;
+        if (!bytes.empty()) memcpy(_sectionAddress[section], bytes.data(), bytes.size());
+    }
+    _entryThunk = _memory + thunkOffset;
+    memcpy(_entryThunk, ENTRY_THUNK, sizeof(ENTRY_THUNK));
+
+    for (const auto& relocation : _encoder.getRelocations()) {
+        const Symbol& s = symbols[relocation.symbol];
+        uint8_t* place = _sectionAddress[relocation.section] + relocation.offset;
+        uint64_t target;
+        if (relocation.type == RelocType::GotPCRel && s.section == -1) target = (uint64_t)allocateSlot(s.name);
+        else if (s.section != -1 && relocation.type != RelocType::GotPCRel) target = (uint64_t)(_sectionAddress[s.section] + s.offset);
+        else if (relocation.type == RelocType::PLT32) {
+            auto it = _stubs.find(s.name);
+            if (it == _stubs.end()) {
+                uint8_t* stub = _sectionAddress[TEXT] + stubsOffset + _stubs.size() * STUB_SIZE;
+                int32_t disp = (int32_t)(allocateSlot(s.name) - (stub + 6));
+                stub[0] = 0xFF; // jmp *disp(%rip)
+                stub[1] = 0x25;
+                memcpy(stub + 2, &disp, 4);
+                stub[6] = 0x0F; // ud2
+                stub[7] = 0x0B;
+                it = _stubs.insert({ s.name, stub }).first;
+            }
+            target = (uint64_t)it->second;
+        }
+        else if (relocation.type == RelocType::Abs64) {
+            uint64_t address;
+            memcpy(&address, allocateSlot(s.name), 8);
+            target = address;
+        }
+        else {
+            // a PC-relative data reference cannot reach the host, and the encoder never emits GOT references to its own symbols
+            throw CompileError("cannot resolve the reference to " + s.name + " in --run mode");
+        }
+
+        if (relocation.type == RelocType::Abs64) {
+            uint64_t value = target + relocation.addend;
+            memcpy(place, &value, 8);
+        }
+        else {
+            int64_t value = (int64_t)(target + relocation.addend - (uint64_t)place);
+            if (value != (int32_t)value) {
+                throw CompileError("relocation out of range for " + s.name);
+            }
+            int32_t value32 = (int32_t)value;
+            memcpy(place, &value32, 4);
+        }
+    }
+
+    if (mprotect(_memory, rxSize, PROT_READ | PROT_EXEC) != 0) {
+        throw CompileError("cannot make the code executable");
+    }
+}
+
+void* Jit::getSymbol(const std::string& name) const
+{
+    for (const auto& s : _encoder.getSymbols()) {
+        if (s.name == name && s.section != -1) return _sectionAddress[s.section] + s.offset;
+    }
+    return nullptr;
+}
+
+int Jit::call(const std::string& function)
+{
+    void* address = getSymbol(function);
+    if (!address) return 0;
+    return ((int (*)(void*))_entryThunk)(address);
+}
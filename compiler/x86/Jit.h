@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include "Encoder.h"
+
+namespace x86 {
+
+/*
+    Loads the machine code of a finished encoder in executable memory to run it in the compiler process (--run).
+
+    The undefined symbols must be bound to host functions or variables before load().
+    Calls to host functions go through jump stubs and the GOT references through address slots,
+    both placed next to the code since the host may be further than 2GB from the mapping.
+    The generated code uses %ebx for the divisions without saving it, so call() goes through a thunk that preserves it.
+*/
+class Jit {
+public:
+    Jit(const Encoder& encoder);
+    ~Jit();
+
+    void bindSymbol(const std::string& name, void* address);
+    void load(); // lays out the sections, applies the relocations and makes the code executable
+    void* getSymbol(const std::string& name) const;
+    int call(const std::string& function); // calls a function without arguments returning an int, 0 if it does not exist
+
+protected:
+    uint8_t* allocateSlot(const std::string& name); // address slot of an undefined symbol
+
+    const Encoder& _encoder;
+    std::map<std::string, void*> _hostSymbols;
+    uint8_t* _memory;
+    size_t _size;
+    uint8_t* _sectionAddress[SECTION_COUNT];
+    uint8_t* _entryThunk;
+    std::map<std::string, uint8_t*> _stubs;
+    std::map<std::string, uint8_t*> _slots;
+};
+
+}
@@ -0,0 +1,69 @@
+/*
+    Runtime of the --buffered-io option of ifcc.
+    Link it with the generated assembly: gcc file.s runtime/ifcc_io.c -o file
+
+    putchar and getchar are replaced by unlocked buffered versions working directly on the file descriptors.
+    The generated code stores the characters in __ifcc_outbuf itself and only calls __ifcc_putchar when the buffer is full.
+    The output buffer is flushed when the program exits and before reading stdin.
+*/
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+
+// must be the same as IO_BUFFER_SIZE in compiler/ir/Runtime.h
+#define IFCC_IO_BUFFER_SIZE 4096
+
+unsigned char __ifcc_outbuf[IFCC_IO_BUFFER_SIZE];
+unsigned int __ifcc_outpos = 0;
+
+static unsigned char inbuf[IFCC_IO_BUFFER_SIZE];
+static unsigned int inpos = 0;
+static unsigned int inlen = 0;
+
+void __ifcc_flush(void)
+{
+    unsigned int done = 0;
+    while (done < __ifcc_outpos) {
+        ssize_t n = write(STDOUT_FILENO, __ifcc_outbuf + done, __ifcc_outpos - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += n;
+    }
+    __ifcc_outpos = 0;
+}
+
+int __ifcc_putchar(int c)
+{
+    if (__ifcc_outpos == IFCC_IO_BUFFER_SIZE) __ifcc_flush();
+    __ifcc_outbuf[__ifcc_outpos++] = (unsigned char)c;
+    return (unsigned char)c;
+}
+
+// writes a whole string, used for the runs of putchar with constant arguments
+void __ifcc_write(const unsigned char* text, unsigned int length)
+{
+    for (unsigned int i = 0; i < length; ++i) {
+        if (__ifcc_outpos == IFCC_IO_BUFFER_SIZE) __ifcc_flush();
+        __ifcc_outbuf[__ifcc_outpos++] = text[i];
+    }
+}
+
+int __ifcc_getchar(void)
+{
+    if (inpos == inlen) {
+        // an interactive program must see its prompt before waiting for input
+        __ifcc_flush();
+        ssize_t n;
+        do n = read(STDIN_FILENO, inbuf, IFCC_IO_BUFFER_SIZE);
+        while (n < 0 && errno == EINTR);
+        if (n <= 0) return -1; // EOF
+        inpos = 0;
+        inlen = n;
+    }
+    return inbuf[inpos++];
+}
+
+__attribute__((constructor)) static void ifcc_io_init(void)
+{
+    atexit(__ifcc_flush);
+}
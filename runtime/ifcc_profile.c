@@ -0,0 +1,100 @@
+/*
+    Runtime of the --profile option of ifcc.
+    Link it with the generated assembly: gcc file.s runtime/ifcc_profile.c -o file
+
+    Every instrumented function owns a record (defined in the generated assembly by ProfileEnter)
+    and calls __ifcc_prof_enter / __ifcc_prof_exit with the value of rdtsc on entry and exit.
+    The flat profile is printed on stderr when the program exits.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+
+struct ifcc_prof_record {
+    const char* name;
+    unsigned long long calls;
+    unsigned long long inclusive; // cycles spent in the function and its callees
+    unsigned long long exclusive; // cycles spent in the function itself
+    unsigned long long active;    // number of calls of the function currently on the stack
+    struct ifcc_prof_record* next;
+};
+
+struct ifcc_prof_frame {
+    struct ifcc_prof_record* record;
+    unsigned long long start;
+    unsigned long long children; // cycles spent in the callees of this call
+};
+
+static struct ifcc_prof_record* records = NULL;
+static struct ifcc_prof_frame* frames = NULL;
+static size_t depth = 0;
+static size_t capacity = 0;
+
+void __ifcc_prof_enter(struct ifcc_prof_record* record, unsigned long long tsc)
+{
+    // records are linked the first time their function is called
+    if (record->calls++ == 0) {
+        record->next = records;
+        records = record;
+    }
+    record->active++;
+
+    if (depth == capacity) {
+        capacity = capacity ? capacity * 2 : 256;
+        frames = realloc(frames, capacity * sizeof(struct ifcc_prof_frame));
+        if (!frames) abort();
+    }
+    frames[depth].record = record;
+    frames[depth].start = tsc;
+    frames[depth].children = 0;
+    depth++;
+}
+
+void __ifcc_prof_exit(struct ifcc_prof_record* record, unsigned long long tsc)
+{
+    struct ifcc_prof_frame* frame = &frames[--depth];
+    unsigned long long elapsed = tsc - frame->start;
+
+    record->exclusive += elapsed - frame->children;
+    // recursive calls are already counted by the outermost call
+    if (--record->active == 0) record->inclusive += elapsed;
+    if (depth > 0) frames[depth - 1].children += elapsed;
+}
+
+static int compare_records(const void* a, const void* b)
+{
+    const struct ifcc_prof_record* ra = *(struct ifcc_prof_record* const*)a;
+    const struct ifcc_prof_record* rb = *(struct ifcc_prof_record* const*)b;
+    if (ra->exclusive != rb->exclusive) return ra->exclusive < rb->exclusive ? 1 : -1;
+    return 0;
+}
+
+static void ifcc_prof_report(void)
+{
+    size_t count = 0;
+    unsigned long long total = 0;
+    for (struct ifcc_prof_record* r = records; r; r = r->next) {
+        count++;
+        total += r->exclusive;
+    }
+    if (count == 0) return;
+
+    struct ifcc_prof_record** sorted = malloc(count * sizeof(struct ifcc_prof_record*));
+    if (!sorted) return;
+    size_t i = 0;
+    for (struct ifcc_prof_record* r = records; r; r = r->next) sorted[i++] = r;
+    qsort(sorted, count, sizeof(struct ifcc_prof_record*), compare_records);
+
+    fprintf(stderr, "Flat profile (cycles):\n");
+    fprintf(stderr, "%7s %16s %16s %12s  %s\n", "% excl", "exclusive", "inclusive", "calls", "function");
+    for (i = 0; i < count; ++i) {
+        const struct ifcc_prof_record* r = sorted[i];
+        double percent = total ? 100.0 * (double)r->exclusive / (double)total : 0.0;
+        fprintf(stderr, "%6.2f%% %16llu %16llu %12llu  %s\n", percent, r->exclusive, r->inclusive, r->calls, r->name);
+    }
+    free(sorted);
+}
+
+__attribute__((constructor)) static void ifcc_prof_init(void)
+{
+    atexit(ifcc_prof_report);
+}
@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+"""
+This script measures the cold start of ifcc on the test corpus (tests/testfiles): every file is compiled by a new
+process, with empty DFA for the ANTLR parser (--dfa=none) and with the DFA of a snapshot loaded at startup (--dfa).
+
+The snapshot is trained by `make dfa` on the same corpus, give another one with --snapshot to measure on files it
+was not trained on. For each configuration, the script prints the total wall time of the processes, which includes
+the loading of the snapshot, and the total time of the parsing phase given by `-ftime-report`.
+
+run `bench-coldstart.py -h` to see the list of arguments
+"""
+
+import argparse
+import glob
+import os
+import re
+import subprocess
+import sys
+import time
+
+def cold_start(ifcc, flags, path, runs):
+    """best wall time and parsing time (ms) over `runs` processes, the compilation may fail (invalid programs)"""
+    best_wall, best_parsing = None, None
+    for _ in range(runs):
+        start = time.perf_counter()
+        result = subprocess.run([ifcc, path, "-o", os.devnull, "-ftime-report"] + flags, capture_output=True, text=True)
+        wall = (time.perf_counter() - start) * 1e3
+        match = re.search(r"^\s+parsing\s+([0-9.]+) ms", result.stderr, re.MULTILINE)
+        parsing = float(match.group(1)) if match else 0.0
+        best_wall = wall if best_wall is None else min(best_wall, wall)
+        best_parsing = parsing if best_parsing is None else min(best_parsing, parsing)
+    return best_wall, best_parsing
+
+def main():
+    root = os.path.join(os.path.dirname(__file__), "..")
+    parser = argparse.ArgumentParser(description="Cold start of ifcc with and without the DFA snapshot")
+    parser.add_argument("--ifcc", default=os.path.join(root, "ifcc"), help="path of the compiler")
+    parser.add_argument("--snapshot", default=os.path.join(root, "ifcc.dfa"), help="DFA snapshot written by make dfa")
+    parser.add_argument("--testdir", default=os.path.join(os.path.dirname(__file__), "testfiles"), help="corpus of C files")
+    parser.add_argument("--runs", type=int, default=3, help="processes per file, the best one is kept")
+    args = parser.parse_args()
+
+    if not os.path.isfile(args.snapshot):
+        print(f"no DFA snapshot {args.snapshot}, run make dfa first")
+        return 1
+    configs = {"cold": ["--dfa=none"], "snapshot": [f"--dfa={args.snapshot}"]}
+    paths = sorted(glob.glob(os.path.join(args.testdir, "**", "*.c"), recursive=True))
+
+    totals = {c: [0.0, 0.0] for c in configs}
+    for path in paths:
+        for c, flags in configs.items():
+            wall, parsing = cold_start(args.ifcc, flags, path, args.runs)
+            totals[c][0] += wall
+            totals[c][1] += parsing
+
+    print(f"{len(paths)} files, best of {args.runs} runs")
+    print(f"{'config':<12}{'wall (ms)':>12}{'parsing (ms)':>15}")
+    for c in configs:
+        print(f"{c:<12}{totals[c][0]:>12.1f}{totals[c][1]:>15.1f}")
+    if totals["snapshot"][0] > 0 and totals["snapshot"][1] > 0:
+        print(f"speedup: {totals['cold'][0] / totals['snapshot'][0]:.2f}x wall, {totals['cold'][1] / totals['snapshot'][1]:.2f}x parsing")
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
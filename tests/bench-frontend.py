@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""
+This script measures the time spent by ifcc in the front-end (lexing and parsing) with different configurations
+of lexers and parsers, using the phases printed by `-ftime-report`.
+
+The inputs are the test corpus (tests/testfiles, every valid program is compiled on its own)
+and large generated programs: long expressions, many functions, deeply nested statements and comments.
+
+run `bench-frontend.py -h` to see the list of arguments
+"""
+
+import argparse
+import os
+import random
+import re
+import subprocess
+import sys
+import tempfile
+import glob
+
+# the first configuration is the reference of the speedups
+CONFIGS = {
+    "antlr-ll": ["--parser=antlr-ll"],
+    "antlr": ["--parser=antlr"],
+    "hand": ["--parser=hand"],
+    "antlr+lexer": ["--parser=antlr", "--lexer=hand"],
+    "hand+lexer": ["--parser=hand", "--lexer=hand"],
+}
+
+def long_expression(terms):
+    """main returns one expression of `terms` terms mixing all the binary operators"""
+    rng = random.Random(terms)
+    ops = ["+", "-", "*", "&", "|", "^", "<", "==", "&&", "||"]
+    expr = "a"
+    for i in range(terms - 1):
+        expr += f" {rng.choice(ops)} " + (f"({rng.randint(1, 9)} * b - c)" if i % 7 == 0 else rng.choice(["a", "b", "c", str(rng.randint(0, 99))]))
+    return f"int main() {{\n    int a = 3, b = 5, c = 7;\n    return {expr};\n}}\n"
+
+def many_functions(count):
+    """`count` small functions called from main"""
+    text = ""
+    for i in range(count):
+        text += f"int f{i}(int x, int y) {{\n    int z = x * {i} + y;\n    if (z > 10) {{\n        z = z - y;\n    }}\n    return z;\n}}\n"
+    calls = " + ".join(f"f{i}({i}, 2)" for i in range(min(count, 50)))
+    return text + f"int main() {{\n    return {calls};\n}}\n"
+
+def nested_blocks(depth):
+    """`depth` nested if/while statements"""
+    text = "int main() {\n    int a = 0, b = 1;\n"
+    for i in range(depth):
+        text += "    " * (i + 1) + ("if (a < 100) {\n" if i % 2 == 0 else "while (b < 0) {\n")
+        text += "    " * (i + 2) + f"a = a + {i};\n"
+    for i in reversed(range(depth)):
+        text += "    " * (i + 1) + "}\n"
+    return text + "    return a;\n}\n"
+
+def commented(text):
+    """`text` with comments, directives and indentation, which the lexers must skip"""
+    text = "#include <stdio.h>\n#define N 10\n" + text
+    text = text.replace("\n    ", "\n        ").replace(";\n", ";    /* a comment at the end of the line */\n")
+    return text.replace("{\n", "{\n    /*\n     * a comment of several lines\n     */\n")
+
+def corpus(testdir):
+    """the valid programs of the test corpus, one input per file"""
+    inputs = []
+    for path in sorted(glob.glob(os.path.join(testdir, "**", "*.c"), recursive=True)):
+        if "invalid" in path or "error" in path:
+            continue
+        with open(path) as f:
+            inputs.append((os.path.relpath(path, testdir), f.read()))
+    return inputs
+
+def front_end_time(ifcc, flags, path, runs, phases):
+    """best time (ms) of the given phases over `runs` runs, None if the compilation fails"""
+    best = None
+    for _ in range(runs):
+        result = subprocess.run([ifcc, path, "-o", os.devnull, "-ftime-report"] + flags, capture_output=True, text=True)
+        if result.returncode != 0:
+            return None
+        total = 0.0
+        for phase in phases:
+            match = re.search(rf"^\s+{phase}\s+([0-9.]+) ms", result.stderr, re.MULTILINE)
+            total += float(match.group(1)) if match else 0.0
+        best = total if best is None else min(best, total)
+    return best
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark of the front-end of ifcc")
+    parser.add_argument("--ifcc", default=os.path.join(os.path.dirname(__file__), "..", "ifcc"), help="path of the compiler")
+    parser.add_argument("--configs", nargs="+", default=list(CONFIGS), choices=list(CONFIGS), help="configurations to compare")
+    parser.add_argument("--runs", type=int, default=3, help="runs per input, the best one is kept")
+    parser.add_argument("--phases", nargs="+", default=["lexing", "parsing"], help="phases of -ftime-report to measure")
+    parser.add_argument("--scale", type=int, default=1, help="multiplies the size of the generated inputs")
+    args = parser.parse_args()
+
+    inputs = [
+        ("expression 10k terms", long_expression(10000 * args.scale)),
+        ("expression 50k terms", long_expression(50000 * args.scale)),
+        ("2000 functions", many_functions(2000 * args.scale)),
+        ("200 nested blocks", nested_blocks(200)),
+        ("commented functions", commented(many_functions(2000 * args.scale))),
+    ]
+    corpus_inputs = corpus(os.path.join(os.path.dirname(__file__), "testfiles"))
+
+    with tempfile.TemporaryDirectory() as tmp:
+        print(f"{'input':<24}{'size':>10}" + "".join(f"{c + ' (ms)':>14}{'MB/s':>9}" for c in args.configs))
+        totals = {c: 0.0 for c in args.configs}
+        for name, text in inputs + [("test corpus", None)]:
+            if text is None:
+                times = {c: 0.0 for c in args.configs}
+                size = 0
+                for i, (_, program) in enumerate(corpus_inputs):
+                    path = os.path.join(tmp, f"corpus{i}.c")
+                    with open(path, "w") as f:
+                        f.write(program)
+                    results = {c: front_end_time(args.ifcc, CONFIGS[c], path, args.runs, args.phases) for c in args.configs}
+                    if None in results.values():
+                        continue
+                    size += len(program)
+                    for c in args.configs:
+                        times[c] += results[c]
+            else:
+                path = os.path.join(tmp, "input.c")
+                with open(path, "w") as f:
+                    f.write(text)
+                size = len(text)
+                times = {c: front_end_time(args.ifcc, CONFIGS[c], path, args.runs, args.phases) for c in args.configs}
+            line = f"{name:<24}{size:>10}"
+            for c in args.configs:
+                if times[c] is None:
+                    line += f"{'failed':>14}{'':>9}"
+                    continue
+                totals[c] += times[c]
+                line += f"{times[c]:>14.2f}{(size / times[c] / 1e3 if times[c] > 0 else 0):>9.1f}"
+            print(line)
+
+        reference = args.configs[0]
+        for c in args.configs[1:]:
+            if totals[c] > 0:
+                print(f"{c}: {totals[reference] / totals[c]:.2f}x faster than {reference}")
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -86,6 +86,10 @@ def parse_args(args: list[str] | None = None):
                             help="For each path given: if it\"s a file, use this file; if it\"s a directory, use all *.c files in this subtree")
     arg_parser.add_argument("-c", "--compiler-path", default="../ifcc",
                             help="The path to the compiler to test (Defaults to 'ifcc')")
+    arg_parser.add_argument("--flags", default="",
+                            help="Flags given to the compiler to test, e.g. --flags='--parser=hand -O' (Defaults to none)")
+    arg_parser.add_argument("--same-as", default=None, metavar="FLAGS",
+                            help="Also check that the diagnostics, exit status and output of the compiler are the same as with FLAGS instead of --flags, e.g. --same-as= for the default pipeline")
     arg_parser.add_argument("-o", "--output", default=None,
                             help="The output directory for the tests. The csv will have the name '<datetime>-<output>.csv' (Defaults to 'ifcc-test-<compilername>')")
     arg_parser.add_argument("-f", "--failed_only", action="store_true",
@@ -217,20 +221,56 @@ class RunResult:
     execute: int = -1
 
 
-def test_compiler(compiler: Compiler, file: str):
+# the compiler executes the program and exits with the status of main
+EXECUTE_FLAGS = ["--run", "--interp", "--interp-check"]
+
+RUNTIME_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "runtime")
+
+# runtime linked with the output of the compiler given these flags (see the README)
+# the program of gcc is linked with it too, so that both programs start the same way
+RUNTIMES = {
+    "--profile": "ifcc_profile.c",
+    "--buffered-io": "ifcc_io.c",
+}
+
+
+def runtime_args(compiler: Compiler):
+    return "".join(f' "{RUNTIME_DIR}/{RUNTIMES[f]}"' for f in compiler.compile_flags.split() if f in RUNTIMES)
+
+
+# the output of the compiler given these flags defines its own _start and I/O on syscalls
+FREESTANDING_FLAGS = ["-ffreestanding", "-nostdlib"]
+
+
+def output_name(compiler: Compiler):
+    return f"0_asm-{compiler.name}" + (".o" if "-c" in compiler.compile_flags.split() else ".s")
+
+
+def compile_file(compiler: Compiler, file: str):
+    """compile `file` with the flags of `compiler`, without the ones executing the program. return exit status"""
+    flags = " ".join(f for f in compiler.compile_flags.split() if f not in EXECUTE_FLAGS)
+    return command(f'"{compiler.path}" {flags} "{file}" -o {output_name(compiler)}', f'0_compile-{compiler.name}.txt')
+
+
+def test_compiler(compiler: Compiler, file: str, link_args: str = ""):
     results = RunResult()
 
-    asm_name = f"0_asm-{compiler.name}"
-    results.compile = command(f'"{compiler.path}" {compiler.compile_flags} "{file}" -o {asm_name}.s', f'0_compile-{compiler.name}.txt')
+    results.compile = compile_file(compiler, file)
     if results.compile != 0:
         return results
 
+    if any(f in EXECUTE_FLAGS for f in compiler.compile_flags.split()):
+        # the program is accepted, it is then executed by the compiler
+        results.link = 0
+        results.execute = command(f'"{compiler.path}" {compiler.compile_flags} "{file}"', f'2_execute-{compiler.name}.txt')
+        return results
+
     bin_name = f"1_bin-{compiler.name}"
-    results.link = command(f'gcc {asm_name}.s -o {bin_name}', f'1_link-{compiler.name}.txt')
+    results.link = command(f'gcc {output_name(compiler)}{link_args} -o {bin_name}', f'1_link-{compiler.name}.txt')
     if results.link != 0:
         return results
 
-    results.execute = command(f'./{bin_name}', f'2_execute-{compiler.name}.txt')
+    results.execute = command(f'./{bin_name} 2> 2_stderr-{compiler.name}.txt', f'2_execute-{compiler.name}.txt')
     return results
 
 
@@ -251,7 +291,28 @@ def passed_color(passed: bool):
 GCC = Compiler("gcc", "gcc", compile_flags="-S")
 
 
-def run_tests(tests: list[TestCase], compiler: Compiler):
+def read_outputs(compiler: Compiler):
+    """diagnostics and exit status of the compilation, and the output of the compiler if any"""
+    with open(f"0_compile-{compiler.name}.txt", "rb") as f:
+        diagnostics = f.read()
+    output = None
+    if os.path.isfile(output_name(compiler)):
+        with open(output_name(compiler), "rb") as f:
+            output = f.read()
+    return diagnostics, output
+
+
+def read_file(name: str):
+    with open(name, "rb") as f:
+        return f.read()
+
+
+def program_output(compiler: Compiler):
+    """stdout of the program, without the exit status logged by `command`"""
+    return read_file(f"2_execute-{compiler.name}.txt").rsplit(b"\nexit status:", 1)[0]
+
+
+def run_tests(tests: list[TestCase], compiler: Compiler, reference: Compiler | None = None):
     print("Running tests...")
     results: list[TestResult] = []
 
@@ -269,8 +330,16 @@ def run_tests(tests: list[TestCase], compiler: Compiler):
             else:
                 print(f"({i+1}/{len(tests)}) {test.name}: {passed_color(passed)} - {step} - {GCC.name}: {gcc_res}, {compiler.name}: {compiler_res} - {comment}")
 
-        gcc_result = test_compiler(GCC, "input.c")
-        compiler_results = test_compiler(compiler, "input.c")
+        gcc_result = test_compiler(GCC, "input.c", runtime_args(compiler))
+        freestanding = any(f in FREESTANDING_FLAGS for f in compiler.compile_flags.split())
+        compiler_results = test_compiler(compiler, "input.c", runtime_args(compiler) + (" -nostdlib -static" if freestanding else ""))
+
+        if reference is not None:
+            reference_compile = compile_file(reference, "input.c")
+            if read_outputs(compiler) != read_outputs(reference):
+                save_result(False, "Same", reference_compile, compiler_results.compile,
+                            f"different diagnostics or output than with '{reference.compile_flags}'")
+                continue
 
         if gcc_result.compile != 0 and compiler_results.compile != 0:
             # ifcc correctly rejects invalid program -> test-case ok
@@ -296,10 +365,24 @@ def run_tests(tests: list[TestCase], compiler: Compiler):
 
         # both compilers  did produce an  executable, so now we  run both
         # these executables and compare the results.
-        if gcc_result.execute != compiler_results.execute:
+        # without a value, the status of main is what was left in %rax by the startup code of the C library,
+        # which is not run by a freestanding program
+        undefined_status = freestanding and re.search(rb"return\S* with no value", read_file(f"0_compile-{GCC.name}.txt")) is not None
+        if gcc_result.execute != compiler_results.execute and not undefined_status:
             save_result(False, "Exe", gcc_result.execute, compiler_results.execute, "different results at execution")
             continue
 
+        # the runtimes replace the I/O or instrument the program, its output must not change
+        if (runtime_args(compiler) or freestanding) and program_output(compiler) != program_output(GCC):
+            save_result(False, "Output", gcc_result.execute, compiler_results.execute, "different output at execution")
+            continue
+
+        # the instrumented program prints its profile on stderr when it exits (not when killed by a signal)
+        if "--profile" in compiler.compile_flags.split() and compiler_results.execute < 128 \
+                and not read_file(f"2_stderr-{compiler.name}.txt").startswith(b"Flat profile"):
+            save_result(False, "Profile", gcc_result.execute, compiler_results.execute, "no profile printed on stderr")
+            continue
+
         save_result(True, "Exe", gcc_result.execute, compiler_results.execute)
     os.chdir(orig_cwd)
     return results
@@ -355,13 +438,20 @@ if __name__ == "__main__":
     setup_logging(args.log)
 
     compiler = check_compiler(args.compiler_path)
-    if args.output is None: args.output = f"ifcc-test-{compiler.name}" 
+    compiler.compile_flags = args.flags
+    reference = None
+    if args.same_as is not None:
+        reference = Compiler(f"{compiler.name}-reference", compiler.path, args.same_as)
+    if args.output is None:
+        # one folder per configuration of the compiler
+        suffix = re.sub(r"[^A-Za-z0-9]+", "-", args.flags).strip("-")
+        args.output = f"ifcc-test-{compiler.name}" + (f"-{suffix}" if suffix else "")
 
     test_files = list_test_files(args.tests)
 
     tests = prepare_tests(args.output, test_files)
 
-    results = run_tests(tests, compiler)
+    results = run_tests(tests, compiler, reference)
 
     stats = compute_stats(results)
 
@@ -370,3 +460,5 @@ if __name__ == "__main__":
     if not args.no_csv:
         save_results(args.output, compiler, results, stats)
 
+    sys.exit(1 if stats.failed else 0)
+
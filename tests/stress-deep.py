@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""
+This script checks that ifcc compiles very deep inputs without overflowing its stack, and that its time grows
+linearly with their size: chains of a million binary operators, and deeply nested blocks, parentheses and
+unary operators.
+
+Each input is compiled with several configurations of the front-end, linked with gcc and executed, and the exit
+status of the program is compared with the expected one. Each input is also compiled at half its size, the ratio
+of the compile times should be close to 2.
+
+The depth of the nesting is limited: the parsers (and the visitors of the ANTLR tree) still recurse on the nested
+blocks, parentheses and unary operators, on the 1 GiB stack of the thread compiling the file. With the hand-written
+parser, 1 000 000 levels pass and 2 000 000 nested parentheses overflow it; a larger --depth is expected to fail.
+
+run `stress-deep.py -h` to see the list of arguments
+"""
+
+import argparse
+import os
+import random
+import subprocess
+import sys
+import tempfile
+import time
+
+CONFIGS = {
+    "antlr": ["--parser=antlr"],
+    "antlr+fused": ["--parser=antlr", "--sema=fused"],
+    "hand": ["--parser=hand", "--lexer=hand"],
+    "hand+fused": ["--parser=hand", "--lexer=hand", "--sema=fused"],
+    "hand+stream": ["--parser=hand", "--lexer=hand", "--stream"],
+}
+
+def additive_chain(terms):
+    """main returns a chain of `terms` additions and subtractions, left associative"""
+    rng = random.Random(terms)
+    parts = ["a"]
+    value = 3
+    for _ in range(terms - 1):
+        op, operand = rng.choice("+-"), rng.randint(0, 9)
+        parts.append(f" {op} {operand}")
+        value = value + operand if op == "+" else value - operand
+    return f"int main() {{\n    int a = 3;\n    return {''.join(parts)};\n}}\n", value
+
+def mixed_chain(terms):
+    """a chain of `terms` operators of several precedences: sums of products separated by ^"""
+    rng = random.Random(terms)
+    parts = ["a"]
+    value, total = 0, 3
+    for i in range(terms - 1):
+        if i % 3 == 0:
+            parts.append(" + 2 * a")
+            total += 6
+        elif rng.random() < 0.1:
+            # ^ has a lower precedence than + and -, it ends the current sum
+            parts.append(f" ^ {i % 7}")
+            value ^= total
+            total = i % 7
+        else:
+            op = rng.choice("+-")
+            parts.append(f" {op} {i % 7}")
+            total = total + i % 7 if op == "+" else total - i % 7
+    return f"int main() {{\n    int a = 3;\n    return {''.join(parts)};\n}}\n", value ^ total
+
+def lazy_chain(terms):
+    """a chain of `terms` operands of && and ||, all true"""
+    parts = ["a"] + [f" {'&&' if i % 2 else '||'} {1 + i % 5}" for i in range(terms - 1)]
+    return f"int main() {{\n    int a = 3;\n    return {''.join(parts)};\n}}\n", 1
+
+def nested_blocks(depth):
+    """`depth` nested blocks, each one incrementing a"""
+    return "int main() {\n    int a = 0;\n" + "{ a = a + 1;\n" * depth + "}\n" * depth + "    return a;\n}\n", depth
+
+def nested_parentheses(depth):
+    """an operand in `depth` parentheses and negations"""
+    return f"int main() {{\n    int a = 5;\n    return {'-(' * depth}a{')' * depth};\n}}\n", 5 if depth % 2 == 0 else -5
+
+def compile_and_run(ifcc, flags, source, tmp, stack_unlimited):
+    """compile time (s) and exit status of the program, or an error message"""
+    path = os.path.join(tmp, "input.c")
+    with open(path, "w") as f:
+        f.write(source)
+    assembly, program = os.path.join(tmp, "input.s"), os.path.join(tmp, "input")
+    start = time.perf_counter()
+    result = subprocess.run([ifcc, path, "-o", assembly] + flags, capture_output=True, text=True)
+    elapsed = time.perf_counter() - start
+    if result.returncode != 0:
+        return elapsed, f"ifcc exited with {result.returncode}: {result.stderr.strip()[-200:]}"
+    if subprocess.run(["gcc", assembly, "-o", program], capture_output=True).returncode != 0:
+        return elapsed, "gcc failed"
+    # the frame of main holds a temporary per operator
+    run = subprocess.run(f"ulimit -s unlimited 2>/dev/null; {program}" if stack_unlimited else program, shell=True)
+    return elapsed, run.returncode
+
+def main():
+    parser = argparse.ArgumentParser(description="Stress test of ifcc on very deep inputs")
+    parser.add_argument("--ifcc", default=os.path.join(os.path.dirname(__file__), "..", "ifcc"), help="path of the compiler")
+    parser.add_argument("--configs", nargs="+", default=list(CONFIGS), choices=list(CONFIGS), help="configurations to test")
+    parser.add_argument("--terms", type=int, default=1000000, help="terms of the chains of operators")
+    parser.add_argument("--depth", type=int, default=100000, help="depth of the nested blocks and parentheses (see the limit above)")
+    args = parser.parse_args()
+
+    inputs = [
+        ("+- chain", additive_chain, args.terms),
+        ("mixed chain", mixed_chain, args.terms),
+        ("&& || chain", lazy_chain, args.terms),
+        ("nested blocks", nested_blocks, args.depth),
+        ("nested parentheses", nested_parentheses, args.depth),
+    ]
+
+    failures = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        print(f"{'input':<20}{'size':>10}{'config':>14}{'time (s)':>10}{'x2 ratio':>10}  result")
+        for name, generate, size in inputs:
+            half, _ = generate(size // 2)
+            source, expected = generate(size)
+            for config in args.configs:
+                half_time, _ = compile_and_run(args.ifcc, CONFIGS[config], half, tmp, True)
+                elapsed, status = compile_and_run(args.ifcc, CONFIGS[config], source, tmp, True)
+                ok = status == expected % 256
+                failures += not ok
+                result = "ok" if ok else f"FAILED: {status}, expected {expected % 256}"
+                print(f"{name:<20}{size:>10}{config:>14}{elapsed:>10.2f}{elapsed / half_time:>10.2f}  {result}")
+    if failures:
+        print(f"{failures} failures")
+    return 1 if failures else 0
+
+if __name__ == "__main__":
+    sys.exit(main())
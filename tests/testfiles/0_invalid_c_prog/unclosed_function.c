@@ -0,0 +1,4 @@
+int main()
+{
+    int a = 42;
+    return a;
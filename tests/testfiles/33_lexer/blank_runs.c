@@ -0,0 +1,49 @@
+int main() {
+    int a = 0;
+    a =	 a
+ +1;
+    a               =               a
+
+
+               +              1;
+    a                =	                a                +               1;
+    a                 =		                 a
+                 +                1;
+    a                               =	                               a
+
+
+                               +                              1;
+    a                                =		                                a                                +                               1;
+    a                                 =                                 a
+                                 +                                1;
+    a                                               =		                                               a
+
+
+                                               +                                              1;
+    a                                                =                                                a                                                +                                               1;
+    a                                                               =                                                               a
+
+
+                                                               +                                                              1;
+    a                                                                =	                                                                a                                                                +                                                               1;
+    a                                                                 =		                                                                 a
+                                                                 +                                                                1;
+                                 
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+    return a;
+}
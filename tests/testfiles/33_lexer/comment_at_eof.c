@@ -0,0 +1,4 @@
+int main() {
+    return 3;
+}
+/* the last comment of the file, without newline */
\ No newline at end of file
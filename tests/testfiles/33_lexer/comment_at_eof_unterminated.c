@@ -0,0 +1,4 @@
+int main() {
+    return 3;
+}
+/* a comment which is never closed
\ No newline at end of file
@@ -0,0 +1,23 @@
+int main() {
+    int a = 1;
+    a = a /**/ + 1;
+    a = a /*c*/ + 1;
+    a = a /*comment * / co*/ + 1;
+    a = a /*comment * / com*/ + 1;
+    a = a /*comment * / comm*/ + 1;
+    a = a /*comment * / comme*/ + 1;
+    a = a /*comment * / comment * / commen*/ + 1;
+    a = a /*comment * / comment * / comment*/ + 1;
+    a = a /*comment * / comment * / comment */ + 1;
+    a = a /*comment * / comment * / comment **/ + 1;
+    a = a /*comment * / comment * / comment * / comment * / comment * / co*/ + 1;
+    a = a /*comment * / comment * / comment * / comment * / comment * / com*/ + 1;
+    a = a /*comment * / comment * / comment * / comment * / comment * / comm*/ + 1;
+    a = a /*comment * / comment * / comment * / comment * / comment * / comme*/ + 1;
+    /* a * comment ** of
+ several / lines
+
+ ending with stars ***/
+    a = a /**/ * 2 /***/;
+    return a; /* xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx */
+}
\ No newline at end of file
@@ -0,0 +1,4 @@
+int main() {
+    return 3;
+}
+int vz_abcdefghijklmnopqrstuvwxyz0123456789_
\ No newline at end of file
@@ -0,0 +1,13 @@
+int main() {
+    int va_abcdefghijkl = 1;
+    int vb_abcdefghijklm = 2;
+    int vc_abcdefghijklmn = 3;
+    int vd_abcdefghijklmnopqrstuvwxyz01 = 4;
+    int ve_abcdefghijklmnopqrstuvwxyz012 = 5;
+    int vf_abcdefghijklmnopqrstuvwxyz0123 = 6;
+    int vg_abcdefghijklmnopqrstuvwxyz0123456789_ABCDEFGHIJKLMNOPQRSTUVWX = 7;
+    int vh_abcdefghijklmnopqrstuvwxyz0123456789_ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz01234567 = 8;
+    int maximum = 2147483647;
+    int digits = 1234567890 - 1234567889;
+    return (maximum - 2147483600) + digits + va_abcdefghijkl + vb_abcdefghijklm + vc_abcdefghijklmn + vd_abcdefghijklmnopqrstuvwxyz01 + ve_abcdefghijklmnopqrstuvwxyz012 + vf_abcdefghijklmnopqrstuvwxyz0123 + vg_abcdefghijklmnopqrstuvwxyz0123456789_ABCDEFGHIJKLMNOPQRSTUVWX + vh_abcdefghijklmnopqrstuvwxyz0123456789_ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz01234567;
+}
@@ -0,0 +1,12 @@
+int fibo(int n)
+{
+    if (n <= 1)
+    {
+        return n;
+    }
+    return fibo(n - 1) + fibo(n - 2);
+}
+int main()
+{
+    return fibo(20);
+}
@@ -0,0 +1,16 @@
+int fibo(int n)
+{
+    if (n <= 1)
+    {
+        return n;
+    }
+    return fibo(n - 1) + fibo(n - 2);
+}
+int main()
+{
+    int a = fibo(21) + fibo(21) + fibo(21) + fibo(21) + fibo(21);
+    int b = fibo(21) + fibo(21) + fibo(21) + fibo(21) + fibo(21);
+    int c = fibo(21) + fibo(21) + fibo(21) + fibo(21) + fibo(21);
+    int d = fibo(21) + fibo(21) + fibo(21) + fibo(21) + fibo(21);
+    return a + b + c + d;
+}